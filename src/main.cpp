@@ -38,57 +38,41 @@ RTC_DATA_ATTR bool internal = false;
 RTC_DATA_ATTR int8_t utc_offset = 0;//utc offset in second
 
 // Watchdog Checks
-Share<bool> clockCheck("Clock Working");
-Share<bool> sleepCheck("Sleep Working");
-Share<bool> measureCheck("Measure Working");
-Share<bool> voltageCheck("Voltage Working");
-Share<bool> sdCheck("SD Working");
-Share<bool> radarCheck("Radar Working");
-Share<bool> bluetoothCheck("Bluetooth Working");
+EventFlags<WatchCheck> watchChecks("Watch Checks"); ///< Each task sets its check-in, the watchdog waits for all of them and clears them
 
 // Flags
-Share<bool> dataReady("Data Ready"); ///< A shared variable to indicate availability of new ultrasonic measurements
-Share<bool> sleepFlag("Sleep Flag"); ///< A shared variable to trigger sleep operations
-Share<bool> clockSleepReady("Clock Sleep Ready"); ///< A shared variable to indicate the clock is ready to sleep
-Share<bool> sonarSleepReady("Sonar Sleep Ready"); ///< A shared variable to indicate the sonar sensor is ready to sleep
-Share<bool> tempSleepReady("Temp Sleep Ready"); ///< A shared variable to indicate the temp sensor is ready to sleep
-Share<bool> sdSleepReady("SD Sleep Ready"); ///< A shared variable to indicate the SD card is ready to sleep
-Share<bool> bluetoothSleepReady("Bluetooth Sleep Ready"); ///< A shared variable to indicate the Bluetooth is ready to sleep
+EventFlags<TaskFlag> taskFlags("Task Flags"); ///< Wake, sleep and hand-over flags the tasks block on, see TaskFlag
 Share<bool> gnssPowerSave("GNSS Power Save");
 Share<bool> gnssMeasureDone("GNSS Positioning Measurment Done");
-Share<bool> gnssDataReady("GNSS buffer ready");
-Share<bool> fileCreated("SD files created");
 //Share<bool> stopOperationSD("Stop SD Operations");///< A shared variable to STOP ALL SD operations
-Share<bool> BluetoothConnected("bluetooth is connected");///< A shared variable to convey ble is connected and stop operations.
-Share<bool> writeFinishedSD("Write Finished");///< A shared variable to indicate SD has finished writing
 
 Share<int8_t> inLongSurvey("inLongSurvey");///< If we are in the Monthly Survey. -1 for non initialized, 0 for not in long sleep, 1 for in long sleep.
 
 
 // Shares from GPS Clock
-Share<int32_t> latitude("Latitude"); ///< The current latitude [Decimal degrees]
-Share<int32_t> longitude("Longitude"); ///< The current longitude [Decimal degrees]
-Share<int32_t> altitude("Altitude"); ///< The current altitude [meters above MSL]
-Share<bool> fixType("Fix Type"); ///< The current fix type
+SnapshotShare<GNSSFix> gnssFix("GNSS Fix"); ///< The current position fix, latitude, longitude and altitude from one reading
 Share<uint32_t> unixTime("Unix Time"); ///< The current Unix timestamp relative to GMT
-Share<String> displayTime("Display Time"); ///< The current time of day relative to GMT
-Share<bool> wakeReady("Wake Ready"); ///< Indicates whether or not the device is ready to wake
+SnapshotShare<Timestamp> displayTime("Display Time"); ///< The current date and time of day relative to GMT, see formatTimestamp()
 Share<uint64_t> sleepTime("Sleep Time"); ///< The number of microseconds to sleep
 
 // Shares from sensors
-Share<int16_t> distance("Distance"); ///< The distance measured by the ultrasonic sensor in millimeters
+SnapshotShare<SampleRecord> lastSample("Last Sample"); ///< The most recent distance measurement with its time and battery readings
 Share<float> temperature("Temperature"); ///< The temperature in Fahrenheit
 Share<float> humidity("Humidity"); ///< The relative humidity in %
 
 // Shares from radar
-Share<bool> radarSleepReady("Radar Sleep");
 Share<int> radarDistance("Radar Distance");
-Share<bool> radarDataReady("Radar Data Ready");
 
 //Shares from GNSS
 Share<int> numSFRBX("Number of SFRBX msgs"); ///<SFRBX msgs received by GNSS module
 Share<int> numRAWX("Number of RAWX msgs"); ///<RAWX msgs received by GNSS module
-uint8_t *myBuffer = new uint8_t[sdWriteSize]; /// <Buffer to copy to SD card
+GNSSBufferPool gnssBuffers(GNSS_BUFFER_SLOTS, sdWriteSize, "GNSS Buffers"); ///< Buffers handed from the clock task to the SD task
+
+// Requests to the SD task
+Queue<SDRequest> sdRequests(SD_QUEUE_SIZE, "SD Requests", pdMS_TO_TICKS(SD_QUEUE_WAIT)); ///< Everything the SD task is asked to write, in order
+
+// BLE events for the Bluetooth task
+Queue<uint8_t> bleEvents(BLE_EVENT_QUEUE_SIZE, "BLE Events"); ///< Posted by the ArduinoBLE event handlers, BLEEventType values
 
 // Duty Cycle
 Share<float> batteryPercent("Battery Percent"); ///< The solar panel voltage
@@ -96,8 +80,6 @@ Share<float> battery("Battery Voltage"); ///< The input voltage to the MCU
 Share<uint32_t> READ_TIME("Read Time"); ///< The current read time in seconds
 Share<uint16_t> MINUTE_ALLIGN("Minute Allign"); ///< The current minute allignment
 
-//Bluetooth Shares
-Share<uint16_t> FILELIST_COUNT("Filelist Count"); //number of filelists generated STARTS FROM Filelist1.txt
 //-----------------------------------------------------------------------------------------------------||
 //-----------------------------------------------------------------------------------------------------||
 
@@ -127,17 +109,6 @@ void setup()
   MINUTE_ALLIGN.put((uint16_t) HI_ALLIGN);
   gnssPowerSave.put(false);
   gnssMeasureDone.put(false);
-  gnssDataReady.put(false);
-  dataReady.put(false);
-  sleepFlag.put(false);
-  clockSleepReady.put(false);
-  sdSleepReady.put(false);
-  tempSleepReady.put(false);
-  sonarSleepReady.put(false);
-  bluetoothSleepReady.put(false);
-  fileCreated.put(false);
-  BluetoothConnected.put(false);
-  writeFinishedSD.put(false);
 
   unixTime.put(0);
 
@@ -146,7 +117,6 @@ void setup()
   Wire.begin(SDA, SCL, CLK);
   // Wire1.begin(SDA2, SCL2, CLK);
 
-  wakeReady.put(false);
   xTaskCreate(taskSD, "SD Task", 8192, NULL, 8, NULL);
 
   xTaskCreate(taskClockGNSS2, "Clock Task", 8192, NULL, 7, NULL);
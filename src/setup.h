@@ -27,6 +27,14 @@
 #define CONTINUOUS
 
 
+/**
+ * @brief Define this constant to log samples as binary records
+ * @details Samples are written to /Data/<hex time>.bin as fixed width records
+ *          with a CRC per block (see sdRecord.h) instead of CSV text
+ * 
+ */
+// #define SD_BINARY_LOG
+
 /**
  * @brief Define the pins for the DEFAULT i2c buses
  * @details 
@@ -39,7 +47,47 @@
 #define CLK 100000
 
 #define MAX_FILESIZE 50*1024 //max size a file can be in kb
-#define BT_TRANSF_SIZE 64*1024 //max size a file can be for bluetooth to transfer
+
+/**
+ * @brief How often samples reach the card
+ * @details Samples are staged in RAM and written in whole sectors, and the
+ *          data file is synced every SD_SYNC_RECORDS samples. A sync leaves
+ *          the last partial sector in RAM, so a reset or power cut loses the
+ *          samples since the last sync plus that sector: at most
+ *          SD_SYNC_RECORDS - 1 samples plus 511 bytes of them, about 26 CSV
+ *          rows or 40 binary records with the values below. SD_FLUSH, the
+ *          start of a wake, sleep and rollover write the partial sector too.
+ * 
+ */
+#define SD_SYNC_RECORDS 10 ///< Number of samples appended between syncs of the open data file
+#define SD_STAGE_SECTORS 2 ///< Number of 512 byte sectors of samples staged in RAM before they are written to the card
+
+/**
+ * @brief Define this constant to pre-allocate data and GNSS files
+ * @details New files are allocated as one contiguous extent up front and
+ *          truncated to their real length when closed, so no FAT/bitmap work
+ *          happens in the middle of logging
+ * 
+ */
+#define SD_PREALLOCATE
+
+/**
+ * @brief Define this constant to count SD card operations
+ * @details The SD task prints the number of writes, syncs and opens, the
+ *          bytes and sectors written and the time spent in each every time
+ *          it closes its files. SD_STATS_DELAY_US is added to every write and
+ *          sync to see how the rest of the system copes with a slower card.
+ * 
+ */
+// #define SD_STATS
+#define SD_STATS_DELAY_US 0 ///< us of extra latency injected into every SD write and sync when SD_STATS is defined
+#define BT_CHUNK_SIZE 100 ///< Bytes of a file sent per BLE notification until the client reports its MTU
+#define BT_MAX_CHUNK_SIZE 244 ///< Most bytes of a file sent per BLE notification, a 247 byte ATT MTU less the 3 byte header
+#define BT_CHUNKS_PER_LOOP 8 ///< Notifications sent per pass of the transfer state before yielding
+#define BT_FRAME_HEADER_SIZE 4 ///< Bytes of file offset at the start of every chunk of a GET transfer
+#define BT_MAX_RETRIES 3 ///< Failed checksums of the same file in a row before the transfer is abandoned
+#define BT_STALL_TIMEOUT 5000 ///< ms a transfer or LIST page waits for the client to take a notification before it is abandoned
+#define BT_LIST_PAGE_SIZE 32 ///< Most directory entries sent for one LIST request
 
 /**
  * @brief Define this constant to enable variable duty cycle
@@ -66,16 +114,20 @@
 // #define FIX_DELAY 1 ///< Seconds to wait for first GPS fix
 
 #define WATCH_TIMER 30*1000 ///< ms of hang time before triggering a reset
+#define WATCH_CHECK_PERIOD 5000 ///< Longest ms a task blocked waiting for a flag goes without checking in with the watchdog
 
 #define MEASUREMENT_PERIOD 100 ///< Measurement task period in ms
-#define SD_PERIOD 10 ///< SD task period in ms
+#define SD_PERIOD 10 ///< ms the clock task waits for the SD task to hand back a GNSS buffer
+#define SD_IDLE_TIMEOUT WATCH_CHECK_PERIOD ///< ms the SD task sleeps on an empty request queue before checking in with the watchdog
+#define SD_QUEUE_SIZE 16 ///< Number of requests the SD task can fall behind by
+#define SD_QUEUE_WAIT 1000 ///< ms a task waits for room in a full SD request queue
 #define CLOCK_PERIOD 100 ///< Clock task period in ms
-#define SLEEP_PERIOD 100 ///< Sleep task period in ms
 #define VOLTAGE_PERIOD 1000 ///< Voltage task period in ms
-#define WATCHDOG_PERIOD 100 ///< Watchdog task period in ms
 #define RADAR_TASK_PERIOD 100
-#define BLE_ADVERT_PERIOD 4800 
-#define BLE_POLLING_FREQ 20
+#define BLE_ADVERT_INTERVAL 1636 ///< Advertising interval in 0.625 ms units (1022.5 ms), advertising runs the whole time the device is awake
+#define BLE_IDLE_PERIOD ((BLE_ADVERT_INTERVAL * 5 + 7) / 8) ///< ms between BLE polls while advertising, the advertising interval rounded up since a connection only starts on an advertising event
+#define BLE_CONNECTED_PERIOD 100 ///< ms between BLE polls while connected and waiting for the client
+#define BLE_EVENT_QUEUE_SIZE 8 ///< Number of BLE events that can wait for the Bluetooth task
 
 // #define R1b 9.54 ///< Larger resistor for battery voltage divider
 // #define R2b 2.96 ///< Smaller resistor for battery voltage divider
@@ -86,6 +138,9 @@
 #define R2s 10.0 ///< Resistor for solar panel voltage divider
 
 #define sdWriteSize 8192 ///<Write data to the SD card in blocks of 8192 bytes
+#define LOG_FILE_SIZE 32*1024 ///< Size in bytes at which the event log moves on to its next file
+#define LOG_FILE_COUNT 4 ///< Number of event log files kept before the oldest is overwritten
+#define GNSS_BUFFER_SLOTS 2 ///< Number of sdWriteSize buffers GNSS data is captured into while the SD task writes
 
 //-----------------------------------------------------------------------------------------------------||
 //-----------------------------------------------------------------------------------------------------||
@@ -14,6 +14,12 @@
 
 #include "waterSenseLibs/shares/taskshare.h"
 #include "waterSenseLibs/shares/taskqueue.h"
+#include "waterSenseLibs/shares/snapshotshare.h"
+#include "waterSenseLibs/shares/eventflags.h"
+#include "waterSenseLibs/zedGNSS/gnssFix.h"
+#include "waterSenseLibs/timeFormat/timeFormat.h"
+#include "waterSenseLibs/gnssBuffer/gnssBuffer.h"
+#include "waterSenseLibs/sdData/sdRequest.h"
 #include "setup.h"
 
 //-----------------------------------------------------------------------------------------------------||
@@ -29,47 +35,66 @@ extern RTC_DATA_ATTR bool internal;
 extern RTC_DATA_ATTR int8_t utc_offset;
 
 
+/**
+ * @brief Flags the tasks coordinate the wake cycle with, held in taskFlags
+ * 
+ */
+enum TaskFlag : EventBits_t
+{
+    FLAG_WAKE_READY = 1 << 0, ///< The clock has a time and the other tasks can start
+    FLAG_FILE_CREATED = 1 << 1, ///< The SD task has opened this wake's files
+    FLAG_SLEEP = 1 << 2, ///< The run time is up, tasks should get ready to sleep
+    FLAG_CLOCK_SLEEP_READY = 1 << 3, ///< The clock task is ready to sleep
+    FLAG_RADAR_SLEEP_READY = 1 << 4, ///< The radar task is ready to sleep
+    FLAG_SD_SLEEP_READY = 1 << 5, ///< The SD task has closed its files
+    FLAG_BLUETOOTH_SLEEP_READY = 1 << 6, ///< The Bluetooth task is ready to sleep
+    FLAG_BLUETOOTH_CONNECTED = 1 << 7, ///< A central is connected, a GNSS survey is not started while it is
+    FLAG_SD_ROLLOVER_DONE = 1 << 8, ///< The SD task has finished the SD_ROLLOVER the Bluetooth task waits on
+
+    FLAGS_SLEEP_READY = FLAG_CLOCK_SLEEP_READY | FLAG_RADAR_SLEEP_READY | FLAG_SD_SLEEP_READY | FLAG_BLUETOOTH_SLEEP_READY ///< Every task the sleep task waits for
+};
+
+/// Combine task flags
+inline TaskFlag operator| (TaskFlag a, TaskFlag b) { return (TaskFlag) ((EventBits_t) a | (EventBits_t) b); }
+
+/**
+ * @brief Check-ins the watchdog waits for, held in watchChecks
+ * @details In the order of the status line and trip mask the watchdog prints
+ * 
+ */
+enum WatchCheck : EventBits_t
+{
+    CHECK_CLOCK = 1 << 0,
+    CHECK_SD = 1 << 1,
+    CHECK_VOLTAGE = 1 << 2,
+    CHECK_SLEEP = 1 << 3,
+    CHECK_RADAR = 1 << 4,
+    CHECK_BLUETOOTH = 1 << 5,
+
+    CHECKS_ALL = CHECK_CLOCK | CHECK_SD | CHECK_VOLTAGE | CHECK_SLEEP | CHECK_RADAR | CHECK_BLUETOOTH ///< Every task the watchdog watches
+};
+
+/// Combine watchdog check-ins
+inline WatchCheck operator| (WatchCheck a, WatchCheck b) { return (WatchCheck) ((EventBits_t) a | (EventBits_t) b); }
+
 // Watchdog Checks
-extern Share<bool> clockCheck;
-extern Share<bool> sleepCheck;
-extern Share<bool> measureCheck;
-extern Share<bool> voltageCheck;
-extern Share<bool> sdCheck;
-extern Share<bool> radarCheck;
-extern Share<bool> bluetoothCheck;
+extern EventFlags<WatchCheck> watchChecks;
 
 // Flags
-extern Share<bool> dataReady;
-extern Share<bool> sleepFlag;
-extern Share<bool> clockSleepReady;
-extern Share<bool> sonarSleepReady;
-extern Share<bool> tempSleepReady;
-extern Share<bool> radarSleepReady;
-extern Share<bool> radarDataReady;
-extern Share<bool> sdSleepReady;
-extern Share<bool> bluetoothSleepReady;
+extern EventFlags<TaskFlag> taskFlags;
 extern Share<bool> gnssPowerSave;
-extern Share<bool> gnssDataReady;
-extern Share<bool> fileCreated;
-extern Share<bool> stopOperationSD;
-extern Share<bool> BluetoothConnected;
-extern Share<bool> writeFinishedSD;
 
 
 extern Share<int8_t> inLongSurvey;
 
 // Shares from GNSS
-extern Share<int32_t> latitude;
-extern Share<int32_t> longitude;
-extern Share<int32_t> altitude;
-extern Share<bool> fixType;
+extern SnapshotShare<GNSSFix> gnssFix;
 extern Share<uint32_t> unixTime;
-extern Share<String> displayTime;
-extern Share<bool> wakeReady;
+extern SnapshotShare<Timestamp> displayTime;
 extern Share<uint64_t> sleepTime;
 
 // Shares from sensors
-extern Share<int16_t> distance;
+extern SnapshotShare<SampleRecord> lastSample;
 extern Share<float> temperature;
 extern Share<float> humidity;
 extern Share<int> radarDistance;
@@ -77,7 +102,13 @@ extern Share<int> radarDistance;
 //Shares from GNSS
 extern Share<int> numSFRBX;
 extern Share<int> numRAWX;
-extern uint8_t *myBuffer;
+extern GNSSBufferPool gnssBuffers;
+
+// Requests to the SD task
+extern Queue<SDRequest> sdRequests;
+
+// BLE events for the Bluetooth task, BLEEventType values
+extern Queue<uint8_t> bleEvents;
 
 // Duty Cycle
 extern Share<float> batteryPercent;
@@ -85,9 +116,6 @@ extern Share<float> battery;
 extern Share<uint32_t> READ_TIME;
 extern Share<uint16_t> MINUTE_ALLIGN;
 
-//Bluetooth shares
-extern Share<uint16_t> FILELIST_COUNT;//number of filelists generated STARTS FROM Filelist1.txt
-
 #endif //SHARED_DATA_H
 
 //-----------------------------------------------------------------------------------------------------||
@@ -14,91 +14,342 @@
 #include "setup.h"
 #include <SdFat.h>
 #include "waterSenseLibs/sdData/sdData.h"
+#include "waterSenseLibs/sdData/sdBus.h"
+#include "waterSenseLibs/crc32/crc32.h"
 
 // Global instance
 BluetoothFileManager bluetoothFileManager;
 
 BluetoothFileManager::BluetoothFileManager() {
-    fileList = "";
-    currentFileData = "";
     currentFileName = "";
     fileLoaded = false;
     currentChecksum = 0;
+    fileSize = 0;
+    position = 0;
+    endPosition = 0;
+    readPosition = 0;
+    block = new uint8_t[BT_BLOCK_SIZE];
+    blockLength = 0;
+    blockPos = 0;
+    pendingCrcCount = 0;
+    recordMode = false;
+    rangeStart = 0;
+    rangeEnd = 0;
+    decimation = 1;
+    matchCount = 0;
+    catalogNext = 0;
+    catalogEnd = 0;
+    recordFormat = CATALOG_CSV;
+    recordCount = 0;
+    lastRecordTime = 0;
+    listRemaining = 0;
+    listEnd = false;
+    codec = CODEC_NONE;
+    pendingRecordLength = 0;
 }
 
 bool BluetoothFileManager::begin() {
-    // Refresh file list on initialization
-    //refreshFileList();
-    if (!SD.begin(SD_CS, SD_SCK_MHZ(10))) {
-        Serial.println("SD card initialization failed!");
-        return false;
-    }
+    // The SD task starts the card, files are only read through sdBus from here
     return true;
 }
 
 
-bool BluetoothFileManager::loadFileFromSD(const String& fileName) {
-    // Clear previous file data
-    currentFileData = "";
-    fileLoaded = false;
-    currentChecksum = 0;
+bool BluetoothFileManager::loadFileFromSD(const String& fileName, uint32_t offset, uint32_t length) {
+    // Close the previous file
+    closeFiles();
+    
+    // The SD task may be part way through writing it
+    if (sdBus.isAppending(fileName.c_str())) {
+        Serial.printf("File is being written: %s\n", fileName.c_str());
+        return false;
+    }
     
     // Open file from SD card
-    File file = SD.open(fileName);
+    currentFile = SD.open(fileName);
     
-    if (!file) {
+    if (!currentFile) {
         Serial.printf("Failed to open file: %s\n", fileName.c_str());
         return false;
     }
     
-    if (file.isDirectory()) {
+    if (currentFile.isDirectory()) {
         Serial.printf("Error: %s is a directory\n", fileName.c_str());
-        file.close();
+        currentFile.close();
         return false;
     }
     
-    // Read file data
-    size_t fileSize = file.size();
-    Serial.printf("Loading file: %s (size: %d bytes)\n", fileName.c_str(), fileSize);
+    // Nothing is read yet, the file is streamed by readChunk()
+    fileSize = currentFile.size();
+    if (offset > fileSize) offset = fileSize;
+    endPosition = (length == 0 || length > fileSize - offset) ? fileSize : offset + length;
+    position = offset;
+    readPosition = offset;
+    if (!currentFile.seekSet(offset)) {
+        Serial.printf("Failed to seek to %u in %s\n", offset, fileName.c_str());
+        currentFile.close();
+        return false;
+    }
+    currentFileName = fileName;
+    fileLoaded = true;
     
-    // Check if file is too large (limit to 64KB for memory safety)
-    if (fileSize > BT_TRANSF_SIZE) {
-        Serial.printf("File too large: %d bytes (max 64KB)\n", fileSize);
-        file.close();
+    Serial.printf("File opened for transfer: %s (size: %u bytes, range %u-%u)\n", fileName.c_str(), fileSize, offset, endPosition);
+    return true;
+}
+
+bool BluetoothFileManager::loadFile(const String& fileName, uint32_t offset, uint32_t length) {
+    SDBusLock lock;
+    return loadFileFromSD(fileName, offset, length);
+}
+
+bool BluetoothFileManager::isFileBusy(const String& fileName) {
+    SDBusLock lock;
+    return sdBus.isAppending(fileName.c_str());
+}
+
+bool BluetoothFileManager::loadRange(uint32_t t0, uint32_t t1, uint16_t decimate) {
+    SDBusLock lock;
+    closeFiles();
+    
+    if (!catalog.begin(false)) {
+        Serial.println("No data catalog, cannot answer record query");
         return false;
     }
     
-    // Pre-allocate string size to prevent memory fragmentation
-    currentFileData.reserve(fileSize);
+    // Every file that could hold a sample of the range
+    CatalogSpan span = catalog.find(t0, t1);
+    catalogNext = span.first;
+    catalogEnd = span.first + span.count;
+    rangeStart = t0;
+    rangeEnd = t1;
+    decimation = decimate ? decimate : 1;
+    matchCount = 0;
+    encoder.reset();
+    lastRecordTime = t0 ? t0 - 1 : 0;
+    recordCount = 0;
+    recordMode = true;
+    fileLoaded = true;
+    currentFileName = "QUERY " + String(t0) + " " + String(t1);
     
-    // Read file into string
-    while (file.available()) {
-        char c = file.read();
-        currentFileData += c;
+    Serial.printf("Query %u to %u: %u file(s) to search\n", t0, t1, span.count);
+    return true;
+}
+
+bool BluetoothFileManager::loadSince(uint32_t since) {
+    if (since == UINT32_MAX) {
+        // Nothing can be newer, an empty range
+        return loadRange(since, 0);
     }
+    return loadRange(since + 1, UINT32_MAX);
+}
+
+bool BluetoothFileManager::reachesOpenFile(uint32_t t0, uint32_t t1) {
+    SDBusLock lock;
+    if (t1 < t0 || !catalog.begin(false)) return false;
     
-    file.close();
+    CatalogEntry entry;
+    bool reaches = catalog.size() > 0 && catalog.read(catalog.size() - 1, entry)
+                   && DataCatalog::covers(entry, t0, t1)
+                   && sdBus.isAppending(DataCatalog::filePath(entry).c_str());
+    catalog.end();
+    return reaches;
+}
+
+bool BluetoothFileManager::setCodec(uint8_t sampleCodec) {
+    if (sampleCodec != CODEC_NONE && sampleCodec != CODEC_DELTA) return false;
+    codec = sampleCodec;
+    return true;
+}
+
+uint8_t BluetoothFileManager::getCodec() {
+    return codec;
+}
+
+uint32_t BluetoothFileManager::getRecordCount() {
+    return recordCount;
+}
+
+uint32_t BluetoothFileManager::getLastRecordTime() {
+    return lastRecordTime;
+}
+
+bool BluetoothFileManager::openNextRecordFile() {
+    while (catalogNext < catalogEnd) {
+        CatalogEntry entry;
+        if (!catalog.read(catalogNext++, entry)) return false;
+        
+        // After the clock was set back the span can hold files outside the range
+        if (!DataCatalog::covers(entry, rangeStart, rangeEnd)) continue;
+        
+        // Its samples are sent once the SD task has moved on to a new file
+        String path = DataCatalog::filePath(entry);
+        if (sdBus.isAppending(path.c_str())) continue;
+        
+        currentFile = SD.open(path.c_str(), O_RDONLY);
+        if (!currentFile) continue;
+        recordFormat = entry.format;
+        
+        // Jump to a sector before the estimate, the samples before the range are skipped anyway.
+        // The first file of each generation can start before the range
+        uint32_t offset = (entry.firstTime < rangeStart) ? DataCatalog::estimateOffset(entry, rangeStart) : 0;
+        offset -= offset % BT_BLOCK_SIZE;
+        offset = (offset > BT_BLOCK_SIZE) ? offset - BT_BLOCK_SIZE : 0;
+        if (offset > 0 && currentFile.seekSet(offset)) {
+            // Drop the partial line the seek landed in
+            if (recordFormat == CATALOG_CSV) {
+                char line[64];
+                currentFile.fgets(line, sizeof(line));
+            }
+            
+            // Start over if the estimate was already inside the range
+            SampleRecord peek;
+            if (!readRecord(peek) || peek.time >= rangeStart) {
+                currentFile.seekSet(0);
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+bool BluetoothFileManager::readRecord(SampleRecord& record) {
+    if (recordFormat == CATALOG_BINARY) {
+        // Skip the file header and the block trailers
+        while (true) {
+            bool header = currentFile.curPosition() == 0;
+            if (currentFile.read(&record, BIN_UNIT_SIZE) != BIN_UNIT_SIZE) return false;
+            if (!header && record.time != BIN_TRAILER_MARKER) return true;
+        }
+    }
     
-    // Set file as loaded and calculate checksum
-    currentFileName = fileName;
-    fileLoaded = true;
-    currentChecksum = calculateChecksum(currentFileData);
+    char line[64];
+    while (currentFile.fgets(line, sizeof(line)) > 0) {
+        unsigned long time;
+        long distance;
+        float battery;
+        float percent;
+        if (sscanf(line, "%lu, %ld, %f, %f", &time, &distance, &battery, &percent) == 4) {
+            record.time = time;
+            record.distance = distance;
+            record.battery = battery;
+            record.batteryPercent = percent;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BluetoothFileManager::nextRecord(SampleRecord& record) {
+    while (true) {
+        if (!currentFile && !openNextRecordFile()) return false;
+        
+        if (!readRecord(record)) {
+            currentFile.close();
+            continue;
+        }
+        if (record.time < rangeStart) continue;
+        
+        // Files are in time order within a generation, nothing after this
+        // sample can be in the range until the clock was set back
+        if (record.time > rangeEnd) {
+            currentFile.close();
+            catalogNext = catalog.generationEnd(catalogNext - 1);
+            continue;
+        }
+        
+        if (matchCount++ % decimation == 0) {
+            recordCount++;
+            lastRecordTime = record.time;
+            return true;
+        }
+    }
+}
+
+size_t BluetoothFileManager::readChunk(uint8_t* buffer, size_t maxLength) {
+    if (!fileLoaded) return 0;
+    SDBusLock lock;
+    
+    if (recordMode) {
+        // Whole records only, one that does not fit is held for the next chunk
+        size_t length = 0;
+        SampleRecord record;
+        while (true) {
+            if (pendingRecordLength == 0) {
+                if (!nextRecord(record)) break;
+                if (codec == CODEC_DELTA) {
+                    pendingRecordLength = encoder.encode(record, pendingRecord);
+                } else {
+                    memcpy(pendingRecord, &record, sizeof(record));
+                    pendingRecordLength = sizeof(record);
+                }
+            }
+            if (length + pendingRecordLength > maxLength) break;
+            memcpy(buffer + length, pendingRecord, pendingRecordLength);
+            length += pendingRecordLength;
+            pendingRecordLength = 0;
+        }
+        currentChecksum = crc32Update(currentChecksum, buffer, length);
+        position += length;
+        return length;
+    }
     
-    Serial.printf("File loaded successfully: %s (%d bytes, checksum: %u)\n", 
-                  fileName.c_str(), currentFileData.length(), currentChecksum);
+    size_t length = 0;
+    while (length < maxLength) {
+        // Refill the block buffer once it has been handed out
+        if (blockPos >= blockLength) {
+            // Read up to the next sector boundary so later reads are aligned,
+            // and never past the end of the range so the checksum covers only it
+            uint32_t want = BT_BLOCK_SIZE - (readPosition % BT_BLOCK_SIZE);
+            if (want > endPosition - readPosition) want = endPosition - readPosition;
+            int count = (want > 0) ? currentFile.read(block, want) : 0;
+            if (count <= 0) {
+                blockLength = 0;
+                blockPos = 0;
+                break;
+            }
+            uint32_t blockCrc = crc32Update(0, block, count);
+            if (pendingCrcCount < BT_PENDING_CRCS) {
+                pendingCrcs[pendingCrcCount].offset = readPosition;
+                pendingCrcs[pendingCrcCount].length = count;
+                pendingCrcs[pendingCrcCount].crc = blockCrc;
+                pendingCrcCount++;
+            }
+            blockLength = count;
+            blockPos = 0;
+            readPosition += count;
+            currentChecksum = crc32Update(currentChecksum, block, blockLength);
+        }
+        
+        // Chunks can span blocks, only the last one of a file is short
+        size_t count = blockLength - blockPos;
+        if (count > maxLength - length) count = maxLength - length;
+        memcpy(buffer + length, block + blockPos, count);
+        blockPos += count;
+        length += count;
+    }
+    position += length;
+    return length;
+}
+
+bool BluetoothFileManager::peekBlockCrc(BlockCrc& blockCrc) {
+    if (pendingCrcCount == 0) return false;
+    
+    blockCrc = pendingCrcs[0];
     return true;
 }
 
-String BluetoothFileManager::getFileList() {
-    return fileList;
+void BluetoothFileManager::popBlockCrc() {
+    if (pendingCrcCount == 0) return;
+    
+    pendingCrcCount--;
+    memmove(pendingCrcs, pendingCrcs + 1, pendingCrcCount * sizeof(BlockCrc));
 }
 
-bool BluetoothFileManager::loadFile(const String& fileName) {
-    return loadFileFromSD(fileName);
+uint32_t BluetoothFileManager::getFileSize() {
+    return fileSize;
 }
 
-String BluetoothFileManager::getFileData() {
-    return currentFileData;
+uint32_t BluetoothFileManager::getPosition() {
+    return position;
 }
 
 String BluetoothFileManager::getCurrentFileName() {
@@ -113,130 +364,121 @@ uint32_t BluetoothFileManager::getCurrentChecksum() {
     return currentChecksum;
 }
 
-uint32_t BluetoothFileManager::calculateChecksum(const String& data) {
-    uint32_t checksum = 0;
-    for (int i = 0; i < data.length(); i++) {
-        checksum = ((checksum << 1) + (uint32_t)data[i]) ^ (checksum >> 31);
-    }
-    return checksum;
+void BluetoothFileManager::clearFile() {
+    SDBusLock lock;
+    closeFiles();
 }
 
-void BluetoothFileManager::clearFile() {
-    currentFileData = "";
+void BluetoothFileManager::closeFiles() {
+    if (currentFile) currentFile.close();
     currentFileName = "";
     fileLoaded = false;
     currentChecksum = 0;
+    fileSize = 0;
+    position = 0;
+    endPosition = 0;
+    readPosition = 0;
+    blockLength = 0;
+    blockPos = 0;
+    pendingCrcCount = 0;
+    recordMode = false;
+    pendingRecordLength = 0;
+    catalog.end();
 }
-bool BluetoothFileManager::generateFileList() {
-    char nameBuf[64];
-    const size_t MAX_FILE_SIZE = MAX_FILESIZE;  // 50 KB
-    int fileIndex = 1;
-    int fileCount = 0;
-
-    auto getFileName = [](int index) {
-        return "/filelist" + String(index) + ".txt";
-    };
-
-   
-    // Remove all existing filelistN.txt files AND MACOS specific ._file stuff in root only
-    File root = SD.open("/");
-    int count = 0;
-    if (root && root.isDirectory()) {
-        File file = root.openNextFile();
-        while (file) {
-            if (!file.isDirectory()) {
-                file.getName(nameBuf, sizeof(nameBuf));
-                String name =  String(nameBuf);// Step 1: Get name
-                file.close();              // Step 2: Close file
-
-                if ((name.indexOf("filelist") != -1) || (name.indexOf("._") != -1)) {
-                    Serial.println("Removing old file: " + name);
-                    SD.remove(String("/")+name.c_str()); // Step 3: Now it's safe
-                }
-            } else {
-                file.close();  // Still close directories too
-            }
-
-            file = root.openNextFile();
-            count++;
-            if(count%100==0)bluetoothCheck.put(true);
-        }
-        root.close();
-    }
-
 
-     // Prepare first file
-    File listFile = SD.open(getFileName(fileIndex).c_str(), O_WRITE | O_CREAT | O_APPEND);
-    if (!listFile) {
-        Serial.println("Failed to create initial filelist");
+bool BluetoothFileManager::openDirectory(const String& path, uint32_t cursor, uint16_t maxEntries) {
+    SDBusLock lock;
+    if (listDir) listDir.close();
+    listRemaining = 0;
+    listEnd = false;
+    
+    // Directory entries are 32 bytes, anything else did not come from getDirectoryCursor()
+    if (cursor % 32) return false;
+    
+    listDir = SD.open(path.c_str(), O_RDONLY);
+    if (!listDir || !listDir.isDirectory() || !listDir.seekSet(cursor)) {
+        if (listDir) listDir.close();
         return false;
     }
+    listRemaining = maxEntries;
+    return true;
+}
 
-    // File rotation logic
-    auto writePath = [&](const String& path) {
-        if (!listFile) return;
-        listFile.println(path);
-        fileCount++;
-
-        // If current file exceeds size limit, roll over
-        if (listFile.size() >= MAX_FILE_SIZE) {
-            listFile.close();
-            fileIndex++;
-            SD.remove(getFileName(fileIndex).c_str());
-            listFile = SD.open(getFileName(fileIndex).c_str(), O_WRITE | O_CREAT | O_APPEND);
-        }
-    };
-
-    // Directory traversal logic
-    count=0;
-    auto listDir = [&](const char* dirName) {
-        if (!SD.exists(dirName)) return;
-        File dir = SD.open(dirName);
-        if (!dir || !dir.isDirectory()) {
-            if (dir) dir.close();
-            return;
+size_t BluetoothFileManager::readDirectory(uint8_t* buffer, size_t maxLength) {
+    char name[64];
+    size_t length = 0;
+    if (maxLength <= sizeof(DirEntry)) return 0;
+    SDBusLock lock;
+    
+    while (listDir && !listEnd && listRemaining > 0) {
+        uint32_t cursor = listDir.curPosition();
+        File entry;
+        if (!entry.openNext(&listDir, O_RDONLY)) {
+            listEnd = true;
+            break;
         }
-        File file = dir.openNextFile();
-        while (file) {
-            file.getName(nameBuf, sizeof(nameBuf));
-            if (!file.isDirectory()&&(String(nameBuf).indexOf("filelist")==-1)) {
-                String fullPath = String(dirName) + "/" + String(nameBuf);
-                writePath(fullPath);
-                Serial.println("Writing path: " + fullPath);
+        
+        size_t nameLength = entry.getName(name, sizeof(name));
+        if (sizeof(DirEntry) + nameLength > maxLength - length) {
+            if (length > 0) {
+                // Left for the next call
+                entry.close();
+                listDir.seekSet(cursor);
+                break;
             }
-            file.close();
-            file = dir.openNextFile();
-            count++;
-            if(count%100==0)bluetoothCheck.put(true);
+            // Too long for a chunk of its own, send as much of the name as fits
+            nameLength = maxLength - sizeof(DirEntry);
         }
-        dir.close();
-    };
-
-    // Walk target directories
-    listDir("/Data");
-    listDir("/GNSS_Data");
-
-    // List root-level files (non-directories)
-    count=0;
-    File rootf = SD.open("/");
-    if (rootf && rootf.isDirectory()) {
-        File file = rootf.openNextFile();
-        while (file) {
-            file.getName(nameBuf, sizeof(nameBuf));
-            if (!file.isDirectory()&&(String(nameBuf).indexOf("filelist")==-1)) {
-                writePath("/" + String(nameBuf));
-                Serial.println("Writing path: " + String(nameBuf));
-            }
-            file.close();
-            file = rootf.openNextFile();
-            count++;
-            if(count%100==0)bluetoothCheck.put(true);
+        
+        DirEntry header;
+        header.flags = entry.isDirectory() ? DIR_ENTRY_DIRECTORY : 0;
+        header.size = entry.isDirectory() ? 0 : entry.fileSize();
+        header.startTime = nameStartTime(name);
+        header.nameLength = nameLength;
+        entry.close();
+        
+        memcpy(buffer + length, &header, sizeof(header));
+        memcpy(buffer + length + sizeof(header), name, nameLength);
+        length += sizeof(header) + nameLength;
+        listRemaining--;
+    }
+    
+    // A page that ends on the last entry is the end of the directory too
+    if (listDir && !listEnd && listRemaining == 0 && length > 0) {
+        uint32_t cursor = listDir.curPosition();
+        File entry;
+        if (entry.openNext(&listDir, O_RDONLY)) {
+            entry.close();
+            listDir.seekSet(cursor);
+        } else {
+            listEnd = true;
         }
-        rootf.close();
     }
+    return length;
+}
 
-    if (listFile) listFile.close();
-    Serial.printf("Generated %d file(s) across %d filelist chunk(s)\n", fileCount, fileIndex);
-    FILELIST_COUNT.put(fileIndex);
-    return true;
+uint32_t BluetoothFileManager::getDirectoryCursor() {
+    return listDir ? listDir.curPosition() : 0;
+}
+
+bool BluetoothFileManager::isDirectoryEnd() {
+    return listEnd;
+}
+
+void BluetoothFileManager::closeDirectory() {
+    SDBusLock lock;
+    if (listDir) listDir.close();
+    listRemaining = 0;
+    listEnd = false;
+}
+
+uint32_t BluetoothFileManager::nameStartTime(const char* name) {
+    char* end;
+    const char* underscore = strchr(name, '_');
+    if (underscore) {
+        uint32_t time = strtoul(underscore + 1, &end, 10);
+        return (end != underscore + 1 && *end == '.') ? time : 0;
+    }
+    uint32_t time = strtoul(name, &end, 16);
+    return (end != name && *end == '.') ? time : 0;
 }
@@ -14,35 +14,122 @@
 
 #include <Arduino.h>
 #include <SdFat.h>
+#include "waterSenseLibs/sdData/sdRecord.h"
+#include "waterSenseLibs/dataCatalog/dataCatalog.h"
+#include "waterSenseLibs/sampleCodec/sampleCodec.h"
+
+#define BT_BLOCK_SIZE 512 ///< Bytes read from the card at a time while streaming a file, one sector
+#define BT_PENDING_CRCS 4 ///< Block CRCs held until the transfer task sends them
+
+/**
+ * @brief The CRC32 of one block of a file, sent so a client can re-request just that block
+ */
+struct __attribute__((packed)) BlockCrc {
+    uint32_t offset; ///< File offset of the block
+    uint16_t length; ///< Bytes in the block, BT_BLOCK_SIZE except at the ends of a range
+    uint32_t crc; ///< CRC32 of the block
+};
+
+/**
+ * @brief Flags of a directory entry
+ */
+enum DirEntryFlags : uint8_t {
+    DIR_ENTRY_DIRECTORY = 0x01 ///< The entry is a directory, size is 0
+};
+
+/**
+ * @brief One entry of a LIST page, followed by nameLength bytes of name without a terminator
+ */
+struct __attribute__((packed)) DirEntry {
+    uint32_t size; ///< File size in bytes
+    uint32_t startTime; ///< Unix time the file was started, taken from its name, 0 if it has none
+    uint8_t flags; ///< DirEntryFlags
+    uint8_t nameLength; ///< Bytes of name that follow
+};
 
 
 class BluetoothFileManager {
 private:
-    String fileList;
-    String currentFileData;
+    File currentFile;
     String currentFileName;
     bool fileLoaded;
     uint32_t currentChecksum;
+    uint32_t fileSize;
+    uint32_t position;
+    uint32_t endPosition;
+    uint32_t readPosition;
+    uint8_t* block;
+    uint16_t blockLength;
+    uint16_t blockPos;
+    BlockCrc pendingCrcs[BT_PENDING_CRCS];
+    uint8_t pendingCrcCount;
+    DataCatalog catalog;
+    bool recordMode;
+    uint32_t rangeStart;
+    uint32_t rangeEnd;
+    uint16_t decimation;
+    uint32_t matchCount;
+    uint32_t catalogNext;
+    uint32_t catalogEnd;
+    uint16_t recordFormat;
+    uint32_t recordCount;
+    uint32_t lastRecordTime;
+    SampleEncoder encoder;
+    uint8_t codec;
+    uint8_t pendingRecord[SAMPLE_CODEC_MAX_SIZE];
+    uint8_t pendingRecordLength;
+    File listDir;
+    uint16_t listRemaining;
+    bool listEnd;
     
     /**
-     * @brief Get file list from SD card
-     * @return String Comma-separated list of files
+     * @brief Open a file on the SD card for streaming
+     * @param fileName Name of file to load
+     * @param offset Byte offset to start at
+     * @param length Number of bytes to stream, 0 for the rest of the file
+     * @return bool True if file loaded successfully
      */
-    String getFileListFromSD();
+    bool loadFileFromSD(const String& fileName, uint32_t offset, uint32_t length);
     
     /**
-     * @brief Load file data from SD card
-     * @param fileName Name of file to load
-     * @return bool True if file loaded successfully
+     * @brief Close the loaded file and forget the transfer, call with the SD bus locked
      */
-    bool loadFileFromSD(const String& fileName);
+    void closeFiles();
     
     /**
-     * @brief Calculate checksum for given data
-     * @param data String data to calculate checksum for
-     * @return uint32_t Checksum value
+     * @brief Open the next data file of a record query
+     * @details A file that starts before the range is searched for its start, it starts
+     *          reading a sector before the catalog's estimate of where it is. That is
+     *          the first file of the range in each clock generation
+     * @return bool True if a file was opened, false once there are no more
      */
-    uint32_t calculateChecksum(const String& data);
+    bool openNextRecordFile();
+    
+    /**
+     * @brief Read the next sample of the open data file, whatever its format
+     * @param record Filled in with the sample
+     * @return bool True if a sample was read, false at the end of the file
+     */
+    bool readRecord(SampleRecord& record);
+    
+    /**
+     * @brief Read the next sample of the range that survives decimation, across files
+     * @details A sample past the range ends its clock generation, the files of a later
+     *          generation are read after it
+     * @param record Filled in with the sample
+     * @return bool True if a sample was read, false once there are no more
+     */
+    bool nextRecord(SampleRecord& record);
+    
+    /**
+     * @brief Get the time a file was started from its name
+     * @details Data files are named after it in hex, GNSS files after the
+     *          wake counter in hex and it in decimal
+     * @param name File name without its directory
+     * @return uint32_t Unix time, 0 if the name does not hold one
+     */
+    static uint32_t nameStartTime(const char* name);
+    
 
 public:
     /**
@@ -57,23 +144,158 @@ public:
     bool begin();
     
     /**
-     * @brief Get the current file list
-     * @return String Current file list
+     * @brief Load a specific file, or a byte range of it
+     * @details The range is clipped to the end of the file. A file the SD
+     *          task is appending to is not loaded, see isFileBusy()
+     * @param fileName Name of file to load
+     * @param offset Byte offset to start at
+     * @param length Number of bytes to stream, 0 for the rest of the file
+     * @return bool True if file loaded successfully
      */
-    String getFileList();
+    bool loadFile(const String& fileName, uint32_t offset = 0, uint32_t length = 0);
     
     /**
-     * @brief Load a specific file
-     * @param fileName Name of file to load
-     * @return bool True if file loaded successfully
+     * @brief Check if the SD task is appending to a file
+     * @details Such a file cannot be loaded until the SD task has closed it
+     * @param fileName Name of the file
+     * @return bool True if the file is being written
+     */
+    bool isFileBusy(const String& fileName);
+    
+    /**
+     * @brief Load every sample taken in a time range, across data files
+     * @details The data catalog finds the files and the first one is entered
+     *          near the start of the range, readChunk() then returns the
+     *          samples oldest first, whatever format they are stored in, as
+     *          16 byte SampleRecords or encoded with the codec set by setCodec()
+     * @param t0 Unix time of the first sample wanted
+     * @param t1 Unix time of the last sample wanted
+     * @param decimate Only every decimate-th sample of the range is returned, 1 for all of them
+     * @return bool True if the catalog could be read
+     */
+    bool loadRange(uint32_t t0, uint32_t t1, uint16_t decimate = 1);
+    
+    /**
+     * @brief Load every sample taken after a time, across data files
+     * @param since The time of the newest sample the client already has
+     * @return bool True if the catalog could be read
+     */
+    bool loadSince(uint32_t since);
+    
+    /**
+     * @brief Check whether a range of samples reaches into the file the SD task is appending to
+     * @details That file is never read, the SD task has to start a new one
+     *          first. It is the newest file in the catalog.
+     * @param t0 Unix time of the first sample of the range
+     * @param t1 Unix time of the last sample of the range
+     * @return bool True if the open data file could hold samples of the range
+     */
+    bool reachesOpenFile(uint32_t t0, uint32_t t1);
+    
+    /**
+     * @brief Choose how the samples of record queries are encoded
+     * @details Takes effect from the next loadRange() or loadSince(), files are always sent as they are
+     * @param sampleCodec A SampleCodec
+     * @return bool True if the codec is supported, the previous one is kept if not
+     */
+    bool setCodec(uint8_t sampleCodec);
+    
+    /**
+     * @brief Get how the samples of record queries are encoded
+     * @return uint8_t A SampleCodec
+     */
+    uint8_t getCodec();
+    
+    /**
+     * @brief Get the number of samples a record query has returned so far
+     * @return uint32_t Number of samples
+     */
+    uint32_t getRecordCount();
+    
+    /**
+     * @brief Get the time of the newest sample a record query has returned
+     * @details After a since query the client sends this back next time as its watermark
+     * @return uint32_t Unix time of the sample, the one before the range if there were none
+     */
+    uint32_t getLastRecordTime();
+    
+    /**
+     * @brief Read the next chunk of the loaded file
+     * @details Reads the card one BT_BLOCK_SIZE block at a time and adds each
+     *          block to the checksum as it is read. The SD bus is held for
+     *          one chunk, so the SD task never waits for longer than that. The buffer is filled
+     *          completely unless the end of the range is reached.
+     * @param buffer Where to put the chunk
+     * @param maxLength Size of buffer
+     * @return size_t Number of bytes read, 0 once the whole range has been read
+     */
+    size_t readChunk(uint8_t* buffer, size_t maxLength);
+    
+    /**
+     * @brief Look at the CRC of the oldest block read by readChunk() that has not been sent yet
+     * @details Blocks are file aligned sectors, so a corrupted one can be
+     *          requested again on its own. The CRC stays until popBlockCrc(),
+     *          so one that could not be sent is tried again.
+     * @param blockCrc Filled in with the block's offset, length and CRC32
+     * @return bool True if there was one
+     */
+    bool peekBlockCrc(BlockCrc& blockCrc);
+    
+    /**
+     * @brief Drop the CRC peekBlockCrc() returned, once it has been sent
+     */
+    void popBlockCrc();
+    
+    /**
+     * @brief Start listing a directory from a cursor
+     * @details Nothing is written to the card, entries are read straight from
+     *          the directory
+     * @param path Directory to list
+     * @param cursor 0 for the first entry, or a cursor from getDirectoryCursor()
+     * @param maxEntries Most entries readDirectory() returns before the page ends
+     * @return bool True if the directory was opened at the cursor
      */
-    bool loadFile(const String& fileName);
+    bool openDirectory(const String& path, uint32_t cursor, uint16_t maxEntries);
     
     /**
-     * @brief Get the currently loaded file data
-     * @return String File data
+     * @brief Read the next entries of the directory being listed
+     * @details Only whole entries are returned, an entry that does not fit is
+     *          left for the next call
+     * @param buffer Where to put the DirEntry records and their names
+     * @param maxLength Size of buffer
+     * @return size_t Number of bytes read, 0 once the page is full or the directory has no more entries
      */
-    String getFileData();
+    size_t readDirectory(uint8_t* buffer, size_t maxLength);
+    
+    /**
+     * @brief Get the cursor of the next entry of the directory being listed
+     * @details A LIST request with this cursor carries on from there
+     * @return uint32_t Position in the directory
+     */
+    uint32_t getDirectoryCursor();
+    
+    /**
+     * @brief Check if the directory being listed has no more entries
+     * @return bool True once the last entry has been read
+     */
+    bool isDirectoryEnd();
+    
+    /**
+     * @brief Stop listing the directory
+     */
+    void closeDirectory();
+    
+    /**
+     * @brief Get the size of the loaded file
+     * @return uint32_t File size in bytes
+     */
+    uint32_t getFileSize();
+    
+    /**
+     * @brief Get the file offset of the next chunk
+     * @return uint32_t Offset in bytes
+     */
+    uint32_t getPosition();
     
     /**
      * @brief Get the currently loaded file name
@@ -88,26 +310,17 @@ public:
     bool isFileLoaded();
     
     /**
-     * @brief Get the checksum of the currently loaded file
+     * @brief Get the CRC32 of the currently loaded file
+     * @details Only covers the bytes read so far, it is the CRC32 of the
+     *          whole range once readChunk() has returned 0
      * @return uint32_t Checksum value
      */
     uint32_t getCurrentChecksum();
     
     /**
-     * @brief Refresh the file list from SD card
-     */
-    void refreshFileList();
-    
-    /**
-     * @brief Clear the currently loaded file data
+     * @brief Close the currently loaded file
      */
     void clearFile();
-    
-    /**
-     * @brief Generate file list as text file
-     * @return bool True if file list generated successfully
-     */
-    bool generateFileList();
 };
 
 // Global instance
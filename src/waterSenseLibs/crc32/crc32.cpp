@@ -0,0 +1,64 @@
+/**
+ * @file crc32.cpp
+ * @brief Table driven CRC32 used to check data on the SD card and over BLE
+ * @version 0.1
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#include "crc32.h"
+
+static uint32_t crcTable[4][256]; ///< Slice-by-4 tables, crcTable[0] is the classic byte table, built on first use
+static bool crcTableReady = false;
+
+/**
+ * @brief Build the lookup tables for the reflected polynomial 0xEDB88320
+ * @details crcTable[k][i] is the CRC of byte i followed by k zero bytes, which
+ *          lets four bytes be folded in with four lookups
+ * 
+ */
+static void buildTable()
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t c = i;
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            c = (c & 1) ? (0xEDB88320UL ^ (c >> 1)) : (c >> 1);
+        }
+        crcTable[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        for (uint8_t k = 1; k < 4; k++)
+        {
+            uint32_t c = crcTable[k - 1][i];
+            crcTable[k][i] = crcTable[0][c & 0xFF] ^ (c >> 8);
+        }
+    }
+    crcTableReady = true;
+}
+
+uint32_t crc32Update(uint32_t crc, const void* data, size_t length)
+{
+    if (!crcTableReady) buildTable();
+
+    const uint8_t* bytes = (const uint8_t*) data;
+    uint32_t c = crc ^ 0xFFFFFFFFUL;
+
+    // Four bytes per step, assembled little endian so alignment does not matter
+    while (length >= 4)
+    {
+        c ^= (uint32_t) bytes[0] | ((uint32_t) bytes[1] << 8) | ((uint32_t) bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+        c = crcTable[3][c & 0xFF] ^ crcTable[2][(c >> 8) & 0xFF] ^ crcTable[1][(c >> 16) & 0xFF] ^ crcTable[0][c >> 24];
+        bytes += 4;
+        length -= 4;
+    }
+    while (length--)
+    {
+        c = crcTable[0][(c ^ *bytes++) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFUL;
+}
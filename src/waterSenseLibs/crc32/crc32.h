@@ -0,0 +1,28 @@
+/**
+ * @file crc32.h
+ * @brief Table driven CRC32 used to check data on the SD card and over BLE
+ * @version 0.1
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Continue a CRC32 (IEEE 802.3, same as zlib) over a block of data
+ * @details Start with a crc of 0 and feed the result back in to checksum data
+ *          in pieces. The result matches zlib.crc32() on the host.
+ * 
+ * @param crc The CRC of the data so far
+ * @param data The next block of data
+ * @param length The number of bytes in the block
+ * @return The CRC of all of the data so far
+ */
+uint32_t crc32Update(uint32_t crc, const void* data, size_t length);
+
+#endif //CRC32_H
@@ -0,0 +1,376 @@
+/**
+ * @file dataCatalog.cpp
+ * @brief An index of the data files kept on the card next to them
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include <vector>
+#include <algorithm>
+#include "dataCatalog.h"
+#include "waterSenseLibs/sdData/sdRecord.h"
+#include "waterSenseLibs/sdData/sdBus.h"
+
+extern SdFat SD;
+
+/**
+ * @brief A method to open the catalog
+ * @details When the catalog is opened for writing and does not exist yet it
+ *          is rebuilt from the files already in /Data
+ *
+ * @param writable Whether the catalog will be written to, only the SD task should
+ * @return Whether or not the catalog is open
+ */
+bool DataCatalog :: begin(bool writable)
+{
+    if (file.isOpen()) return true;
+
+    bool exists = SD.exists(CATALOG_PATH);
+    if (!exists && !writable) return false;
+
+    if (!file.open(CATALOG_PATH, writable ? (O_RDWR | O_CREAT) : O_RDONLY))
+    {
+        Serial.println("Failed to open data catalog");
+        return false;
+    }
+    if (writable)
+    {
+        sdBus.setAppending(SD_BUS_CATALOG, CATALOG_PATH);
+        sdBus.countOpen();
+    }
+    writing = writable;
+
+    // Drop an entry cut short by a power loss
+    uint32_t length = file.fileSize();
+    entryCount = length / CATALOG_ENTRY_SIZE;
+    if (writable && (length % CATALOG_ENTRY_SIZE))
+    {
+        file.truncate(entryCount * CATALOG_ENTRY_SIZE);
+    }
+
+    if (writable && !exists)
+    {
+        rebuild();
+    }
+
+    return true;
+}
+
+/**
+ * @brief A method to close the catalog
+ * @details Once the SD task closes it, GET can send the catalog like any file
+ *
+ */
+void DataCatalog :: end()
+{
+    if (file.isOpen())
+    {
+        file.close();
+    }
+    if (writing)
+    {
+        sdBus.setAppending(SD_BUS_CATALOG, NULL);
+        writing = false;
+    }
+}
+
+/**
+ * @brief A method to get the number of entries
+ *
+ * @return The number of entries
+ */
+uint32_t DataCatalog :: size()
+{
+    return entryCount;
+}
+
+/**
+ * @brief A method to read one entry
+ *
+ * @param index The index of the entry
+ * @param entry Filled in with the entry
+ * @return Whether or not the entry was read
+ */
+bool DataCatalog :: read(uint32_t index, CatalogEntry &entry)
+{
+    if (!file.isOpen() || index >= entryCount) return false;
+    if (!file.seekSet((uint64_t) index * CATALOG_ENTRY_SIZE)) return false;
+
+    return file.read(&entry, CATALOG_ENTRY_SIZE) == CATALOG_ENTRY_SIZE;
+}
+
+/**
+ * @brief A method to overwrite or append one entry
+ * @details The generation of the entry is set here, the caller's copy is not
+ *          looked at. An appended entry that starts before the last one
+ *          starts a new generation. A rewritten entry keeps its generation,
+ *          so its firstTime should only ever be raised.
+ *
+ * @param index The index of the entry, size() to append
+ * @param entry The entry to write
+ * @return Whether or not the entry was written
+ */
+bool DataCatalog :: write(uint32_t index, const CatalogEntry &entry)
+{
+    if (!file.isOpen() || index > entryCount) return false;
+
+    CatalogEntry stored = entry;
+    CatalogEntry before;
+    stored.generation = 0;
+    if (index < entryCount)
+    {
+        if (!read(index, before)) return false;
+        stored.generation = before.generation;
+    }
+    else if (index > 0)
+    {
+        if (!read(index - 1, before)) return false;
+        stored.generation = before.generation + (entry.firstTime < before.firstTime ? 1 : 0);
+    }
+
+    if (!file.seekSet((uint64_t) index * CATALOG_ENTRY_SIZE)) return false;
+    if (sdBus.write(file, &stored, CATALOG_ENTRY_SIZE) != CATALOG_ENTRY_SIZE) return false;
+
+    if (index == entryCount)
+    {
+        entryCount++;
+    }
+    return sdBus.sync(file);
+}
+
+/**
+ * @brief A method to find the files that cover [t0, t1]
+ * @details Two binary searches on firstTime per generation, so a query reads
+ *          O(log n) entries however many files there are. With more than one
+ *          generation the span runs from the first file that covers the
+ *          window to the last, and can hold files in between that do not.
+ *          Check each with covers().
+ *
+ * @param t0 The start of the window
+ * @param t1 The end of the window
+ * @return The entries whose files cover the window, count 0 if none do
+ */
+CatalogSpan DataCatalog :: find(uint32_t t0, uint32_t t1)
+{
+    CatalogSpan span = {0, 0};
+    if (t1 < t0) return span;
+
+    uint32_t low = 0;
+    while (low < entryCount)
+    {
+        uint32_t high = generationEnd(low);
+        CatalogSpan part = findIn(low, high, t0, t1);
+        if (part.count)
+        {
+            if (span.count == 0) span.first = part.first;
+            span.count = part.first + part.count - span.first;
+        }
+        low = high;
+    }
+    return span;
+}
+
+/**
+ * @brief A method to check whether a file could hold samples of [t0, t1]
+ * @details An entry whose file is still open, or was rebuilt, has no lastTime
+ *          and is only checked against t1
+ *
+ * @param entry The entry of the file
+ * @param t0 The start of the window
+ * @param t1 The end of the window
+ * @return Whether or not the file could hold samples of the window
+ */
+bool DataCatalog :: covers(const CatalogEntry &entry, uint32_t t0, uint32_t t1)
+{
+    if (entry.firstTime > t1) return false;
+    return (entry.flags & (CATALOG_OPEN | CATALOG_REBUILT)) || entry.lastTime >= t0;
+}
+
+/**
+ * @brief A method to guess where a time is in a file
+ * @details Assumes samples are evenly spaced between firstTime and lastTime.
+ *          Binary offsets land on the start of a sample, CSV offsets can land
+ *          mid line and the reader should skip to the next newline.
+ *
+ * @param entry The entry of the file
+ * @param time The time to look for
+ * @return A byte offset into the file
+ */
+uint32_t DataCatalog :: estimateOffset(const CatalogEntry &entry, uint32_t time)
+{
+    if (entry.records == 0 || entry.lastTime <= entry.firstTime || time <= entry.firstTime) return 0;
+    if (time > entry.lastTime) return entry.bytes;
+
+    uint32_t index = (uint64_t) (time - entry.firstTime) * (entry.records - 1) / (entry.lastTime - entry.firstTime);
+
+    if (entry.format == CATALOG_BINARY)
+    {
+        // Units after the header, the last unit of every sector is a trailer
+        const uint32_t perSector = BIN_SECTOR_SIZE / BIN_UNIT_SIZE - 1;
+        uint32_t unit = index + 1;
+        return ((unit / perSector) * (perSector + 1) + unit % perSector) * BIN_UNIT_SIZE;
+    }
+
+    return (uint64_t) entry.bytes * index / entry.records;
+}
+
+/**
+ * @brief A method to get the path of an entry's file
+ *
+ * @param entry The entry of the file
+ * @return The path of the file
+ */
+String DataCatalog :: filePath(const CatalogEntry &entry)
+{
+    String path = "/Data/";
+    path += String(entry.nameTime, HEX);
+    path += (entry.format == CATALOG_BINARY) ? ".bin" : ".txt";
+    return path;
+}
+
+/**
+ * @brief A method to find the files that cover [t0, t1] in one generation
+ *
+ * @param low The first entry of the generation
+ * @param high One past the last entry of the generation
+ * @param t0 The start of the window
+ * @param t1 The end of the window
+ * @return The entries whose files cover the window, count 0 if none do
+ */
+CatalogSpan DataCatalog :: findIn(uint32_t low, uint32_t high, uint32_t t0, uint32_t t1)
+{
+    CatalogSpan span = {0, 0};
+
+    // The file holding t0 is the last one to start at or before it
+    uint32_t first = upperBound(low, high, t0);
+    if (first > low)
+    {
+        first--;
+
+        CatalogEntry entry;
+        if (read(first, entry) && !covers(entry, t0, t1))
+        {
+            first++;
+        }
+    }
+
+    uint32_t last = upperBound(first, high, t1);
+    if (last > first)
+    {
+        span.first = first;
+        span.count = last - first;
+    }
+    return span;
+}
+
+/**
+ * @brief A method to find the first entry that starts after a time
+ *
+ * @param low The first entry to search, all in [low, high) one generation
+ * @param high One past the last entry to search
+ * @param time The time to compare firstTime against
+ * @return The index of the first entry with firstTime > time, high if none
+ */
+uint32_t DataCatalog :: upperBound(uint32_t low, uint32_t high, uint32_t time)
+{
+    CatalogEntry entry;
+
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low) / 2;
+        if (!read(middle, entry)) break;
+
+        if (entry.firstTime <= time)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief A method to find where the generation of an entry ends
+ *
+ * @param low An entry of the generation
+ * @return The index of the first entry of a later generation, size() if none
+ */
+uint32_t DataCatalog :: generationEnd(uint32_t low)
+{
+    uint32_t high = entryCount;
+    CatalogEntry entry;
+    if (!read(low, entry)) return high;
+
+    uint32_t generation = entry.generation;
+    low++;
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low) / 2;
+        if (!read(middle, entry)) return entryCount;
+
+        if (entry.generation <= generation)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief A method to index data files written before there was a catalog
+ * @details Only runs once, when the catalog is first created. Files are
+ *          indexed by the time in their name, the number of samples and the
+ *          time of the last one are left unknown.
+ *
+ * @return Whether or not the entries were written
+ */
+bool DataCatalog :: rebuild()
+{
+    ExFile dir = SD.open("/Data", O_RDONLY);
+    if (!dir || !dir.isDirectory()) return false;
+
+    std::vector<CatalogEntry> entries;
+    ExFile next;
+    char name[32];
+    while (next.openNext(&dir, O_RDONLY))
+    {
+        next.getName(name, sizeof(name));
+
+        char* ext = NULL;
+        uint32_t nameTime = strtoul(name, &ext, 16);
+        bool binary = ext && strcmp(ext, ".bin") == 0;
+        if (!next.isDirectory() && ext != name && (binary || (ext && strcmp(ext, ".txt") == 0)))
+        {
+            CatalogEntry entry = {};
+            entry.nameTime = nameTime;
+            entry.firstTime = nameTime;
+            entry.bytes = next.fileSize();
+            entry.format = binary ? CATALOG_BINARY : CATALOG_CSV;
+            entry.flags = CATALOG_REBUILT;
+            entries.push_back(entry);
+        }
+        next.close();
+    }
+    dir.close();
+
+    std::sort(entries.begin(), entries.end(), [](const CatalogEntry &a, const CatalogEntry &b) { return a.firstTime < b.firstTime; });
+
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        if (sdBus.write(file, &entries[i], CATALOG_ENTRY_SIZE) != CATALOG_ENTRY_SIZE) return false;
+        entryCount++;
+    }
+    Serial.printf("Data catalog rebuilt with %u files\n", (unsigned) entries.size());
+    return sdBus.sync(file);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file dataCatalog.h
+ * @brief An index of the data files kept on the card next to them
+ * @details /Data/index.bin holds one fixed size CatalogEntry per data file,
+ *          in the order the files were created. Files are normally created
+ *          in time order so the entries are sorted by firstTime, and the files
+ *          that cover a time window are found with a binary search instead of
+ *          listing /Data and parsing every name.
+ *
+ *          When the clock is set back a new file can start before the one it
+ *          follows. Its entry then starts a new generation, and each
+ *          generation is searched on its own. Generations only ever grow, so
+ *          where each one starts is found with a binary search too.
+ *
+ *          An entry is appended when a data file is created and rewritten in
+ *          place when the file is closed. Entries are CATALOG_ENTRY_SIZE bytes
+ *          so an update never straddles two sectors.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef DATA_CATALOG_H
+#define DATA_CATALOG_H
+
+#include <Arduino.h>
+#include <SdFat.h>
+
+#define CATALOG_PATH "/Data/index.bin" ///< Where the catalog lives on the card
+#define CATALOG_ENTRY_SIZE 32 ///< Size of one catalog entry in bytes
+
+/**
+ * @brief How the samples in a data file are stored
+ *
+ */
+enum CatalogFormat : uint16_t
+{
+    CATALOG_CSV, ///< Text lines, see writeData()
+    CATALOG_BINARY ///< 16 byte units with block trailers, see sdRecord.h
+};
+
+/**
+ * @brief Flags of a catalog entry
+ *
+ */
+enum CatalogFlags : uint16_t
+{
+    CATALOG_OPEN = 0x01, ///< The file has not been closed, lastTime, records and bytes are not final
+    CATALOG_REBUILT = 0x02 ///< Rebuilt from the directory listing, only nameTime and bytes are known
+};
+
+/**
+ * @brief One data file, little endian on the card
+ *
+ */
+struct __attribute__((packed)) CatalogEntry
+{
+    uint32_t nameTime; ///< Unix time the file is named after, in hex
+    uint32_t firstTime; ///< Unix time of the first sample
+    uint32_t lastTime; ///< Unix time of the last sample
+    uint32_t records; ///< Number of samples in the file
+    uint32_t bytes; ///< Size of the file in bytes
+    uint16_t format; ///< A CatalogFormat
+    uint16_t flags; ///< CatalogFlags
+    uint32_t generation; ///< Set by the catalog, one more than the entry before if this one starts before it
+    uint32_t reserved; ///< Zero
+};
+
+static_assert(sizeof(CatalogEntry) == CATALOG_ENTRY_SIZE, "CatalogEntry must be CATALOG_ENTRY_SIZE bytes");
+
+/**
+ * @brief A range of catalog entries, [first, first + count)
+ *
+ */
+struct CatalogSpan
+{
+    uint32_t first; ///< Index of the first entry
+    uint32_t count; ///< Number of entries
+};
+
+class DataCatalog
+{
+    protected:
+        ExFile file; ///< The catalog file
+        uint32_t entryCount = 0; ///< Number of entries in the catalog
+        bool writing = false; ///< Opened for writing, registered with sdBus as being appended to
+
+        bool rebuild(void); ///< A method to index data files written before there was a catalog
+        uint32_t upperBound(uint32_t low, uint32_t high, uint32_t time); ///< A method to find the first entry that starts after a time
+        CatalogSpan findIn(uint32_t low, uint32_t high, uint32_t t0, uint32_t t1); ///< A method to find the files that cover [t0, t1] in one generation
+
+    public:
+        bool begin(bool writable); ///< A method to open the catalog
+
+        void end(void); ///< A method to close the catalog
+
+        uint32_t size(void); ///< A method to get the number of entries
+
+        bool read(uint32_t index, CatalogEntry &entry); ///< A method to read one entry
+
+        bool write(uint32_t index, const CatalogEntry &entry); ///< A method to overwrite or append one entry
+
+        CatalogSpan find(uint32_t t0, uint32_t t1); ///< A method to find the files that cover [t0, t1]
+
+        uint32_t generationEnd(uint32_t low); ///< A method to find where the generation of an entry ends
+
+        static bool covers(const CatalogEntry &entry, uint32_t t0, uint32_t t1); ///< A method to check whether a file could hold samples of [t0, t1]
+
+        static uint32_t estimateOffset(const CatalogEntry &entry, uint32_t time); ///< A method to guess where a time is in a file
+
+        static String filePath(const CatalogEntry &entry); ///< A method to get the path of an entry's file
+};
+
+#endif //DATA_CATALOG_H
@@ -0,0 +1,273 @@
+/**
+ * @file eventLog.cpp
+ * @brief An append-only, size-rotated binary log of system events
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include "eventLog.h"
+#include "sharedData.h"
+#include "waterSenseLibs/sdData/sdBus.h"
+
+#define WATCHDOG_TRIP_MAGIC 0x50495254 ///< Marks watchdogTrip as valid, "TRIP"
+
+extern SdFat SD;
+
+/// Sequence number of the current log file, 0 until it has been looked up after a cold boot
+static RTC_DATA_ATTR uint32_t logSequence = 0;
+
+/// Set to WATCHDOG_TRIP_MAGIC when watchdogTrip holds a trip that has not been logged yet
+static RTC_NOINIT_ATTR uint32_t watchdogTripMagic;
+
+/// The watchdog trip to log after the reset, kept in memory that survives it
+static RTC_NOINIT_ATTR EventRecord watchdogTrip;
+
+/**
+ * @brief A method to open the current log file for appends
+ * @details After a cold boot the log files are read once to find the newest
+ *          one, after that the sequence number is kept in RTC memory so a wake
+ *          from deep sleep only opens one file
+ *
+ * @return Whether or not the log file is open
+ */
+bool EventLog :: open()
+{
+    if (file.isOpen()) return true;
+
+    if (logSequence == 0)
+    {
+        if (!SD.exists("/Log"))
+        {
+            SD.mkdir("/Log");
+        }
+
+        logSequence = findSequence();
+        if (logSequence == 0) return rotate();
+    }
+
+    if (!openSequence(logSequence, false)) return rotate();
+    if (fileSize >= LOG_FILE_SIZE) return rotate();
+
+    return true;
+}
+
+/**
+ * @brief A method to append one record
+ * @details Starts the next log file first if the record does not fit
+ *
+ * @param record The record to append
+ * @return Whether or not the whole record was written
+ */
+bool EventLog :: append(const EventRecord &record)
+{
+    if (!file.isOpen()) return false;
+
+    if (fileSize + EVENT_RECORD_SIZE > LOG_FILE_SIZE)
+    {
+        if (!rotate()) return false;
+    }
+
+    size_t written = sdBus.write(file, &record, EVENT_RECORD_SIZE);
+    fileSize += written;
+    return written == EVENT_RECORD_SIZE;
+}
+
+/**
+ * @brief A method to append an event that happens now
+ *
+ * @param type What happened
+ * @param source Which task is logging it
+ * @param value0 The first event specific value
+ * @param value1 The second event specific value
+ * @param value2 The third event specific value
+ * @return Whether or not the whole record was written
+ */
+bool EventLog :: append(EventType type, EventSource source, int32_t value0, int32_t value1, int32_t value2)
+{
+    EventRecord record;
+    record.time = unixTime.get();
+    record.wake = wakeCounter;
+    record.type = type;
+    record.source = source;
+    record.value[0] = value0;
+    record.value[1] = value1;
+    record.value[2] = value2;
+    return append(record);
+}
+
+/**
+ * @brief A method to flush appended records to the card
+ *
+ */
+void EventLog :: sync()
+{
+    if (file.isOpen())
+    {
+        sdBus.sync(file);
+    }
+}
+
+/**
+ * @brief A method to close the current log file
+ *
+ */
+void EventLog :: close()
+{
+    if (file.isOpen())
+    {
+        file.close();
+    }
+    sdBus.setAppending(SD_BUS_LOG, NULL);
+}
+
+/**
+ * @brief A method to find the newest log file after a cold boot
+ *
+ * @return The highest sequence number found, 0 if there are no log files
+ */
+uint32_t EventLog :: findSequence()
+{
+    uint32_t newest = 0;
+    char path[20];
+
+    for (uint8_t i = 0; i < LOG_FILE_COUNT; i++)
+    {
+        snprintf(path, sizeof(path), "/Log/log%u.bin", i);
+        ExFile candidate = SD.open(path, O_RDONLY);
+        if (!candidate) continue;
+
+        EventRecord first;
+        if (candidate.read(&first, EVENT_RECORD_SIZE) == EVENT_RECORD_SIZE
+            && first.type == EVENT_LOG_START && (uint32_t) first.value[0] > newest)
+        {
+            newest = first.value[0];
+        }
+        candidate.close();
+    }
+
+    return newest;
+}
+
+/**
+ * @brief A method to open the log file for a sequence number
+ * @details A record cut short by a power loss is dropped so that every record
+ *          in the file stays aligned. A new file gets its EVENT_LOG_START record.
+ *
+ * @param sequence The sequence number, it picks one of LOG_FILE_COUNT files
+ * @param truncate Whether to throw away what the file held before
+ * @return Whether or not the file was opened
+ */
+bool EventLog :: openSequence(uint32_t sequence, bool truncate)
+{
+    char path[20];
+    snprintf(path, sizeof(path), "/Log/log%u.bin", (unsigned) (sequence % LOG_FILE_COUNT));
+
+    close();
+    if (!file.open(path, O_RDWR | O_CREAT | (truncate ? O_TRUNC : O_APPEND)))
+    {
+        Serial.printf("Failed to open event log %s\n", path);
+        return false;
+    }
+    sdBus.setAppending(SD_BUS_LOG, path);
+    sdBus.countOpen();
+
+    fileSize = file.fileSize();
+    if (fileSize % EVENT_RECORD_SIZE)
+    {
+        fileSize -= fileSize % EVENT_RECORD_SIZE;
+        file.truncate(fileSize);
+    }
+
+    if (fileSize == 0)
+    {
+        EventRecord start = {};
+        start.time = unixTime.get();
+        start.wake = wakeCounter;
+        start.type = EVENT_LOG_START;
+        start.source = SOURCE_SD;
+        start.value[0] = sequence;
+        fileSize += sdBus.write(file, &start, EVENT_RECORD_SIZE);
+    }
+
+    return true;
+}
+
+/**
+ * @brief A method to start the next log file
+ * @details The oldest of the LOG_FILE_COUNT files is overwritten
+ *
+ * @return Whether or not the new file was opened
+ */
+bool EventLog :: rotate()
+{
+    close();
+    logSequence++;
+    return openSequence(logSequence, true);
+}
+
+/**
+ * @brief A function to hand an event to the SD task without waiting
+ * @details Safe to call from any task. The event is dropped if the SD request
+ *          queue is full rather than holding up the caller.
+ *
+ * @param type What happened
+ * @param source Which task is logging it
+ * @param value0 The first event specific value
+ * @param value1 The second event specific value
+ * @param value2 The third event specific value
+ * @return Whether or not the event was queued
+ */
+bool logEvent(EventType type, EventSource source, int32_t value0, int32_t value1, int32_t value2)
+{
+    SDRequest request;
+    request.type = SD_EVENT;
+    request.event.time = unixTime.get();
+    request.event.wake = wakeCounter;
+    request.event.type = type;
+    request.event.source = source;
+    request.event.value[0] = value0;
+    request.event.value[1] = value1;
+    request.event.value[2] = value2;
+
+    return xQueueSendToBack(sdRequests.get_handle(), &request, 0) == pdTRUE;
+}
+
+/**
+ * @brief A function to remember a watchdog trip across the reset it causes
+ * @details Only touches RTC memory, so it is safe to call right before the
+ *          watchdog aborts even if the SD task is the one that hung
+ *
+ * @param time The unix time of the trip
+ * @param missedMask A mask of the tasks that missed their check-in
+ */
+void noteWatchdogTrip(uint32_t time, int32_t missedMask)
+{
+    EventRecord trip = {};
+    trip.time = time;
+    trip.wake = wakeCounter;
+    trip.type = EVENT_WATCHDOG;
+    trip.source = SOURCE_WATCH;
+    trip.value[0] = missedMask;
+
+    watchdogTrip = trip;
+    watchdogTripMagic = WATCHDOG_TRIP_MAGIC;
+}
+
+/**
+ * @brief A function to take the watchdog trip remembered before the last reset
+ *
+ * @param record Filled in with the trip if there was one
+ * @return Whether or not there was a trip that has not been logged yet
+ */
+bool takeWatchdogTrip(EventRecord &record)
+{
+    if (watchdogTripMagic != WATCHDOG_TRIP_MAGIC) return false;
+
+    record = watchdogTrip;
+    watchdogTripMagic = 0;
+    return true;
+}
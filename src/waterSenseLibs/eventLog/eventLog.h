@@ -0,0 +1,120 @@
+/**
+ * @file eventLog.h
+ * @brief An append-only, size-rotated binary log of system events
+ * @details Events are fixed size records appended to /Log/logN.bin. Once a
+ *          file reaches LOG_FILE_SIZE the next of LOG_FILE_COUNT files is
+ *          truncated and started, so the log never takes more than
+ *          LOG_FILE_COUNT * LOG_FILE_SIZE bytes of the card. Every file
+ *          starts with an EVENT_LOG_START record holding its sequence number,
+ *          tools/wslog2csv.py uses it to put the files back in order.
+ *
+ *          Only the SD task touches the card. Other tasks call logEvent(),
+ *          which hands the record to the SD task without waiting.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include "setup.h"
+
+#define EVENT_RECORD_SIZE 24 ///< Size of one log record in bytes
+
+/**
+ * @brief What happened
+ *
+ */
+enum EventType : uint16_t
+{
+    EVENT_LOG_START, ///< First record of every log file, value 0 is the file sequence number
+    EVENT_BOOT, ///< Power on or reset, value 0 is the esp_reset_reason()
+    EVENT_WAKE, ///< Woke from deep sleep, values are battery mV and battery percent x100
+    EVENT_SLEEP, ///< Files closed for sleep, value 0 is ms spent awake
+    EVENT_FIX, ///< GNSS fix, values are latitude (1e-7 deg), longitude (1e-7 deg) and altitude (m MSL)
+    EVENT_WATCHDOG, ///< Logged on the boot after a watchdog trip, value 0 is a mask of the tasks that missed their check-in
+    EVENT_ERROR, ///< Something failed, value 0 is an error code specific to the source
+    EVENT_BLE_CONNECT, ///< A central connected
+    EVENT_BLE_DISCONNECT ///< The central disconnected, value 0 is ms connected
+};
+
+/**
+ * @brief Which task logged the event
+ *
+ */
+enum EventSource : uint16_t
+{
+    SOURCE_SD,
+    SOURCE_CLOCK,
+    SOURCE_RADAR,
+    SOURCE_SLEEP,
+    SOURCE_BLUETOOTH,
+    SOURCE_WATCH
+};
+
+/**
+ * @brief Error codes logged as value 0 of EVENT_ERROR
+ *
+ */
+enum EventError : int32_t
+{
+    ERROR_DATA_FILE = 1, ///< The data file could not be created
+    ERROR_GNSS_FILE, ///< The GNSS file could not be created
+    ERROR_SD_QUEUE_FULL, ///< Requests to the SD task were dropped, value 1 is the SDRequestType and value 2 is how many
+    ERROR_RADAR_BEGIN, ///< The radar did not start, value 1 is the driver error
+    ERROR_RADAR_MEASURE ///< A radar measurement failed, value 1 is the driver error
+};
+
+/**
+ * @brief One record of the event log, little endian on the card
+ *
+ */
+struct __attribute__((packed)) EventRecord
+{
+    uint32_t time; ///< Unix time (GMT) of the event
+    uint32_t wake; ///< Wake counter at the time of the event
+    uint16_t type; ///< An EventType
+    uint16_t source; ///< An EventSource
+    int32_t value[3]; ///< Event specific values, see EventType
+};
+
+static_assert(sizeof(EventRecord) == EVENT_RECORD_SIZE, "EventRecord must be EVENT_RECORD_SIZE bytes");
+
+class EventLog
+{
+    protected:
+        ExFile file; ///< The current log file, open while the SD task is awake
+        uint32_t fileSize = 0; ///< Size of the current log file in bytes, tracked in RAM
+
+        uint32_t findSequence(void); ///< A method to find the newest log file after a cold boot
+        bool openSequence(uint32_t sequence, bool truncate); ///< A method to open the log file for a sequence number
+        bool rotate(void); ///< A method to start the next log file
+
+    public:
+        bool open(void); ///< A method to open the current log file for appends
+
+        bool append(const EventRecord &record); ///< A method to append one record
+
+        /// A method to append an event that happens now
+        bool append(EventType type, EventSource source, int32_t value0 = 0, int32_t value1 = 0, int32_t value2 = 0);
+
+        void sync(void); ///< A method to flush appended records to the card
+
+        void close(void); ///< A method to close the current log file
+};
+
+/// A function to hand an event to the SD task without waiting
+bool logEvent(EventType type, EventSource source, int32_t value0 = 0, int32_t value1 = 0, int32_t value2 = 0);
+
+/// A function to remember a watchdog trip across the reset it causes
+void noteWatchdogTrip(uint32_t time, int32_t missedMask);
+
+/// A function to take the watchdog trip remembered before the last reset, if any
+bool takeWatchdogTrip(EventRecord &record);
+
+#endif //EVENT_LOG_H
@@ -0,0 +1,121 @@
+/**
+ * @file gnssBuffer.cpp
+ * @brief A pool of GNSS capture buffers handed back and forth between tasks
+ * @version 0.1
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#include "gnssBuffer.h"
+
+/**
+ * @brief A constructor for the GNSSBufferPool class
+ * @details Every buffer starts out free, owned by the producer
+ * 
+ * @param count The number of buffers, 2 for simple ping-pong buffering
+ * @param size The size of each buffer in bytes
+ * @param name A name to be shown in the list of task shares
+ */
+GNSSBufferPool :: GNSSBufferPool(uint8_t count, uint16_t size, const char* name)
+    : freeSlots(count, name, 0)
+{
+    slotCount = count;
+    slotSize = size;
+
+    buffers = new uint8_t*[count];
+    fills = new uint32_t[count];
+    overflows = new uint32_t[count];
+    for (uint8_t i = 0; i < count; i++)
+    {
+        buffers[i] = new uint8_t[size];
+        fills[i] = 0;
+        overflows[i] = 0;
+        freeSlots.put(i);
+    }
+}
+
+/**
+ * @brief A method for the producer to take a free buffer
+ * @details Never blocks. When every buffer is still waiting to be written the
+ *          caller should leave its data where it is and try again later.
+ *          Nothing is lost by that, so it is not counted as an overflow.
+ * 
+ * @param slot Set to the index of the buffer that was taken
+ * @return The buffer, or NULL if none were free
+ */
+uint8_t* GNSSBufferPool :: acquire(uint8_t &slot)
+{
+    if (freeSlots.is_empty())
+    {
+        return NULL;
+    }
+
+    freeSlots.get(slot);
+    fills[slot]++;
+
+    uint8_t inUse = slotCount - freeSlots.available();
+    if (inUse > highWater) highWater = inUse;
+
+    return buffers[slot];
+}
+
+/**
+ * @brief A method for the consumer to give a written buffer back
+ * @details The consumer must not touch the buffer after this
+ * 
+ * @param slot The buffer that was written
+ */
+void GNSSBufferPool :: release(uint8_t slot)
+{
+    freeSlots.put(slot);
+}
+
+/**
+ * @brief A method to give back a filled buffer whose data was not written
+ * @details Used by the producer when the SD task could not take the block and
+ *          by the SD task when the block came too late. Counts one overflow
+ *          against the buffer, its data is lost.
+ * 
+ * @param slot The buffer that was filled
+ */
+void GNSSBufferPool :: drop(uint8_t slot)
+{
+    overflows[slot]++;
+    freeSlots.put(slot);
+}
+
+uint8_t* GNSSBufferPool :: data(uint8_t slot)
+{
+    return buffers[slot];
+}
+
+uint16_t GNSSBufferPool :: size()
+{
+    return slotSize;
+}
+
+uint32_t GNSSBufferPool :: getOverflows(uint8_t slot)
+{
+    return overflows[slot];
+}
+
+uint8_t GNSSBufferPool :: getHighWater()
+{
+    return highWater;
+}
+
+/**
+ * @brief A method to print the overflow and high water counters
+ * 
+ * @param printer Reference to a serial device on which to print
+ */
+void GNSSBufferPool :: printStats(Print &printer)
+{
+    printer.printf("GNSS buffers: high water %u of %u\n", highWater, slotCount);
+    for (uint8_t i = 0; i < slotCount; i++)
+    {
+        printer.printf("  buffer %u filled %u times, %u blocks dropped\n", i, fills[i], overflows[i]);
+    }
+}
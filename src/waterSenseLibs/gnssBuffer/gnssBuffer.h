@@ -0,0 +1,63 @@
+/**
+ * @file gnssBuffer.h
+ * @brief A pool of GNSS capture buffers handed back and forth between tasks
+ * @details The clock task fills a free buffer with raw UBX data and hands it
+ *          to the SD task as an SD_GNSS_BLOCK request. The SD task writes it
+ *          out and hands it back. A buffer is
+ *          owned by exactly one task at a time, so extraction can never write
+ *          into a buffer the SD task is still copying from.
+ * @version 0.1
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#ifndef GNSS_BUFFER_H
+#define GNSS_BUFFER_H
+
+#include <Arduino.h>
+#include "waterSenseLibs/shares/taskqueue.h"
+
+/**
+ * @brief A filled buffer on its way to the SD task
+ * 
+ */
+struct GNSSBlock
+{
+    uint8_t slot; ///< Index of the buffer in the pool
+    uint16_t length; ///< Number of valid bytes in the buffer
+};
+
+class GNSSBufferPool
+{
+    protected:
+        uint8_t** buffers; ///< One buffer of slotSize bytes per slot
+        uint8_t slotCount; ///< Number of buffers in the pool
+        uint16_t slotSize; ///< Size of each buffer in bytes
+        Queue<uint8_t> freeSlots; ///< Buffers owned by the producer
+        uint32_t* fills; ///< Number of times each buffer has been filled
+        uint32_t* overflows; ///< Number of blocks filled in each buffer that were dropped instead of written
+        uint8_t highWater = 0; ///< Most buffers ever in use at once
+
+    public:
+        GNSSBufferPool(uint8_t count, uint16_t size, const char* name); ///< A constructor for the GNSSBufferPool class
+
+        uint8_t* acquire(uint8_t &slot); ///< A method for the producer to take a free buffer
+
+        void release(uint8_t slot); ///< A method for the consumer to give a written buffer back
+
+        void drop(uint8_t slot); ///< A method to give back a filled buffer whose data was not written
+
+        uint8_t* data(uint8_t slot); ///< A method to get the memory of a buffer
+
+        uint16_t size(void); ///< A method to get the size of each buffer
+
+        uint32_t getOverflows(uint8_t slot); ///< A method to get the number of blocks dropped from a buffer
+
+        uint8_t getHighWater(void); ///< A method to get the most buffers ever in use at once
+
+        void printStats(Print &printer); ///< A method to print the overflow and high water counters
+};
+
+#endif //GNSS_BUFFER_H
@@ -0,0 +1,92 @@
+/**
+ * @file sampleCodec.cpp
+ * @brief Lossless delta + varint encoding of sample streams sent over BLE
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "sampleCodec.h"
+
+/**
+ * @brief Write one LEB128 varint
+ *
+ * @param out Where to write it, needs room for 5 bytes
+ * @param value The value to write
+ * @return The number of bytes written
+ */
+static size_t putVarint(uint8_t* out, uint32_t value)
+{
+    size_t length = 0;
+    while (value >= 0x80)
+    {
+        out[length++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    out[length++] = value;
+    return length;
+}
+
+/**
+ * @brief Map a signed difference to an unsigned one, small either way
+ *
+ * @param value The difference
+ * @return 0, -1, 1, -2, 2... mapped to 0, 1, 2, 3, 4...
+ */
+static uint32_t zigzag(int32_t value)
+{
+    return ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+}
+
+/**
+ * @brief Get the bits of a float
+ *
+ * @param value The float
+ * @return Its IEEE 754 bits
+ */
+static uint32_t floatBits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/**
+ * @brief A constructor for the encoder
+ *
+ */
+SampleEncoder :: SampleEncoder()
+{
+    reset();
+}
+
+/**
+ * @brief A method to start a new stream
+ * @details The next record is encoded against an all zero one
+ *
+ */
+void SampleEncoder :: reset()
+{
+    memset(&previous, 0, sizeof(previous));
+}
+
+/**
+ * @brief A method to encode the next record
+ *
+ * @param record The record to encode
+ * @param out Where to write it, needs room for SAMPLE_CODEC_MAX_SIZE bytes
+ * @return The number of bytes written
+ */
+size_t SampleEncoder :: encode(const SampleRecord &record, uint8_t* out)
+{
+    size_t length = 0;
+    length += putVarint(out + length, zigzag((int32_t) (record.time - previous.time)));
+    length += putVarint(out + length, zigzag((int32_t) ((uint32_t) record.distance - (uint32_t) previous.distance)));
+    length += putVarint(out + length, floatBits(record.battery) ^ floatBits(previous.battery));
+    length += putVarint(out + length, floatBits(record.batteryPercent) ^ floatBits(previous.batteryPercent));
+
+    previous = record;
+    return length;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file sampleCodec.h
+ * @brief Lossless delta + varint encoding of sample streams sent over BLE
+ * @details Each SampleRecord is encoded against the one before it as four
+ *          LEB128 varints, least significant 7 bits first:
+ *
+ *          1. time - previous time, zigzag encoded
+ *          2. distance - previous distance, zigzag encoded
+ *          3. battery bits XOR previous battery bits
+ *          4. batteryPercent bits XOR previous batteryPercent bits
+ *
+ *          The previous record starts out all zero, so the first record of a
+ *          stream carries absolute values. Regular samples with a steady
+ *          battery take 4 to 6 bytes instead of 16. tools/wsdelta2csv.py
+ *          decodes the stream.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef SAMPLE_CODEC_H
+#define SAMPLE_CODEC_H
+
+#include <Arduino.h>
+#include "waterSenseLibs/sdData/sdRecord.h"
+
+#define SAMPLE_CODEC_MAX_SIZE 20 ///< Most bytes one encoded record can take, four 5 byte varints
+
+/**
+ * @brief How samples are encoded on the wire
+ *
+ */
+enum SampleCodec : uint8_t
+{
+    CODEC_NONE, ///< Packed 16 byte SampleRecords
+    CODEC_DELTA ///< Delta + varint, see above
+};
+
+class SampleEncoder
+{
+    protected:
+        SampleRecord previous; ///< The last record encoded
+
+    public:
+        SampleEncoder(void); ///< A constructor for the encoder
+
+        void reset(void); ///< A method to start a new stream
+
+        size_t encode(const SampleRecord &record, uint8_t* out); ///< A method to encode the next record
+};
+
+#endif //SAMPLE_CODEC_H
@@ -0,0 +1,191 @@
+/**
+ * @file sdBus.cpp
+ * @brief Arbitration between the tasks that use the SD card
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "sdBus.h"
+
+SDBus sdBus;
+
+/**
+ * @brief A constructor for the bus
+ *
+ */
+SDBus :: SDBus()
+{
+    memset(appending, 0, sizeof(appending));
+}
+
+/**
+ * @brief A method to wait for the card and take it
+ *
+ */
+void SDBus :: lock()
+{
+    mutex.take();
+}
+
+/**
+ * @brief A method to hand the card back
+ *
+ */
+void SDBus :: unlock()
+{
+    mutex.give();
+}
+
+/**
+ * @brief A method to record the file being appended to
+ *
+ * @param file Which of the SD task's files it is
+ * @param path The path of the file, NULL or empty once it is closed
+ */
+void SDBus :: setAppending(SDBusFile file, const char* path)
+{
+    snprintf(appending[file], SD_BUS_PATH_SIZE, "%s", path ? path : "");
+}
+
+/**
+ * @brief A method to check if a file is being appended to
+ * @details Paths are compared without a leading slash and ignoring case, the
+ *          way exFAT looks them up
+ *
+ * @param path The path of the file
+ * @return Whether or not the SD task is appending to it
+ */
+bool SDBus :: isAppending(const char* path)
+{
+    if (path[0] == '/') path++;
+
+    for (uint8_t i = 0; i < SD_BUS_FILES; i++)
+    {
+        const char* other = appending[i];
+        if (other[0] == '/') other++;
+        if (other[0] != '\0' && strcasecmp(path, other) == 0) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief A method to write to a file, counting it
+ * @details With SD_STATS defined the write is timed and SD_STATS_DELAY_US is
+ *          added to it, otherwise this is just file.write(). The sectors are
+ *          counted from where the write ended, a file opened with O_APPEND
+ *          only moves to its end inside write().
+ *
+ * @param file The file to write to
+ * @param data The bytes to write
+ * @param length The number of bytes to write
+ * @return The number of bytes written
+ */
+size_t SDBus :: write(ExFile &file, const void* data, size_t length)
+{
+#ifdef SD_STATS
+    uint32_t start = micros();
+    size_t written = file.write(data, length);
+    if (SD_STATS_DELAY_US > 0) delayMicroseconds(SD_STATS_DELAY_US);
+    uint32_t elapsed = micros() - start;
+
+    stats.writes++;
+    stats.bytes += written;
+    if (written > 0)
+    {
+        uint64_t end = file.curPosition();
+        stats.sectors += (end - 1) / SD_SECTOR_SIZE - (end - written) / SD_SECTOR_SIZE + 1;
+    }
+    stats.writeMicros += elapsed;
+    if (elapsed > stats.maxMicros) stats.maxMicros = elapsed;
+    return written;
+#else
+    return file.write(data, length);
+#endif
+}
+
+/**
+ * @brief A method to sync a file, counting it
+ *
+ * @param file The file to sync
+ * @return Whether or not the sync worked
+ */
+bool SDBus :: sync(ExFile &file)
+{
+#ifdef SD_STATS
+    uint32_t start = micros();
+    bool synced = file.sync();
+    if (SD_STATS_DELAY_US > 0) delayMicroseconds(SD_STATS_DELAY_US);
+    uint32_t elapsed = micros() - start;
+
+    stats.syncs++;
+    stats.syncMicros += elapsed;
+    if (elapsed > stats.maxMicros) stats.maxMicros = elapsed;
+    return synced;
+#else
+    return file.sync();
+#endif
+}
+
+/**
+ * @brief A method to count a file being created or reopened for writing
+ *
+ */
+void SDBus :: countOpen()
+{
+#ifdef SD_STATS
+    stats.opens++;
+#endif
+}
+
+/**
+ * @brief A method to get the operation counters
+ * @details The counters stay at zero unless SD_STATS is defined
+ *
+ * @return The operation counters since boot or the last resetStats()
+ */
+const SDStats& SDBus :: getStats()
+{
+    return stats;
+}
+
+/**
+ * @brief A method to start the operation counters over
+ *
+ */
+void SDBus :: resetStats()
+{
+    stats = SDStats();
+}
+
+/**
+ * @brief A method to print the operation counters
+ *
+ * @param printer Where to print them, e.g. Serial
+ */
+void SDBus :: printStats(Print &printer)
+{
+    printer.printf("SD stats: %u writes, %u bytes, %u sectors, %u syncs, %u opens, write %u us, sync %u us, max %u us\n",
+        stats.writes, stats.bytes, stats.sectors, stats.syncs, stats.opens,
+        stats.writeMicros, stats.syncMicros, stats.maxMicros);
+}
+
+/**
+ * @brief A constructor that takes the bus lock
+ *
+ */
+SDBusLock :: SDBusLock()
+{
+    sdBus.lock();
+}
+
+/**
+ * @brief A destructor that gives the bus lock back
+ *
+ */
+SDBusLock :: ~SDBusLock()
+{
+    sdBus.unlock();
+}
@@ -0,0 +1,109 @@
+/**
+ * @file sdBus.h
+ * @brief Arbitration between the tasks that use the SD card
+ * @details The SD task writes and the Bluetooth task reads, each through its
+ *          own file handles, but SdFat keeps one volume and one cache per
+ *          card, so only one of them may be inside SdFat at a time. Both hold
+ *          the bus lock for every card operation, the SD task for one request
+ *          and the Bluetooth task for one chunk, so neither waits for long.
+ *
+ *          The SD task also records which files it is appending to. Their
+ *          directory entries and the cache are only settled when they are
+ *          closed, so readers leave them alone.
+ *
+ *          Writes and syncs go through write() and sync() here, whoever makes
+ *          them, so that with SD_STATS defined every operation on the card is
+ *          counted in one place.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef SD_BUS_H
+#define SD_BUS_H
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include "setup.h"
+#include "waterSenseLibs/shares/mutex.h"
+
+#define SD_BUS_PATH_SIZE 40 ///< Longest path of a file being appended, with its terminator
+#define SD_SECTOR_SIZE 512 ///< Size of one card sector in bytes
+
+/**
+ * @brief Counters of the operations sent to the card, see SD_STATS
+ *
+ */
+struct SDStats
+{
+    uint32_t writes; ///< Number of writes
+    uint32_t bytes; ///< Bytes written
+    uint32_t sectors; ///< Card sectors touched by writes, a partial sector counts as a whole one
+    uint32_t syncs; ///< Number of syncs
+    uint32_t opens; ///< Number of files created or reopened for writing
+    uint32_t writeMicros; ///< Total time spent writing in us
+    uint32_t syncMicros; ///< Total time spent syncing in us
+    uint32_t maxMicros; ///< Longest single write or sync in us
+};
+
+/**
+ * @brief The files the SD task appends to
+ *
+ */
+enum SDBusFile : uint8_t
+{
+    SD_BUS_DATA, ///< The data file
+    SD_BUS_GNSS, ///< The GNSS file
+    SD_BUS_LOG, ///< The event log file, /Log/logN.bin
+    SD_BUS_CATALOG, ///< The data catalog, /Data/index.bin
+    SD_BUS_FILES ///< Number of files above
+};
+
+class SDBus
+{
+    protected:
+        Mutex mutex; ///< Held by whichever task is using the card
+        char appending[SD_BUS_FILES][SD_BUS_PATH_SIZE]; ///< Paths of the files being appended to, empty if none
+        SDStats stats = {}; ///< Operation counters, only kept when SD_STATS is defined
+
+    public:
+        SDBus(void); ///< A constructor for the bus
+
+        void lock(void); ///< A method to wait for the card and take it
+
+        void unlock(void); ///< A method to hand the card back
+
+        void setAppending(SDBusFile file, const char* path); ///< A method to record the file being appended to, call with the bus locked
+
+        bool isAppending(const char* path); ///< A method to check if a file is being appended to, call with the bus locked
+
+        size_t write(ExFile &file, const void* data, size_t length); ///< A method to write to a file, counting it
+
+        bool sync(ExFile &file); ///< A method to sync a file, counting it
+
+        void countOpen(void); ///< A method to count a file being created or reopened for writing
+
+        const SDStats& getStats(void); ///< A method to get the operation counters
+
+        void resetStats(void); ///< A method to start the operation counters over
+
+        void printStats(Print &printer); ///< A method to print the operation counters
+};
+
+/**
+ * @brief Holds the bus lock for as long as it is in scope
+ *
+ */
+class SDBusLock
+{
+    public:
+        SDBusLock(void); ///< A constructor that takes the bus lock
+
+        ~SDBusLock(void); ///< A destructor that gives the bus lock back
+};
+
+extern SDBus sdBus; ///< The one SD card
+
+#endif //SD_BUS_H
@@ -13,6 +13,8 @@
 #include <SdFat.h>
 #include <utility>
 #include "sdData.h"
+#include "sdBus.h"
+#include "waterSenseLibs/crc32/crc32.h"
 SdFat SD;
 /**
  * @brief A constructor for the SD_Data class
@@ -77,7 +79,8 @@ void SD_Data :: writeHeader()
             "Cal Poly Tide Sensor Ver. 3, Now With Radar AND BLE :)\n"
             "https://github.com/Eclypsee/WaterSense\n\n"
             "Data File format:\n"
-            "UNIX Time (GMT), Distance (mm), External Temp (F), Humidity (%), Battery Voltage (V), Solar Panel Voltage (V)\n"
+            "UNIX Time (GMT), Distance (mm), Battery Voltage (V), Battery (%%)\n\n"
+            "Event log: /Log/log*.bin, convert with tools/wslog2csv.py\n"
             "Current Battery %: %f V\n", battery.get());
         read_me.close();
 
@@ -100,13 +103,16 @@ ExFile SD_Data :: createFile(uint32_t time)
     // Filenames are at most 8 characters + 6("/Data/") + 4(".txt") + null terminator = 19
 
     fileName += String(time, HEX);
-    fileName += ".txt";
+    fileName += DATA_FILE_EXT;
 
     ExFile file = SD.open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC);
     this->DataFilePath = fileName;
     Serial.println("Asserting file SDTASK");
     Serial.flush();
     assert(file);
+
+    // Rollover happens on the first append past MAX_FILESIZE, leave room for it
+    preAllocateFile(file, MAX_FILESIZE + SD_STAGE_SIZE);
     return file;
 }
 
@@ -142,31 +148,326 @@ ExFile SD_Data :: createGNSSFile()
     Serial.println("Failed to create UBX data file! Freezing..."); 
 
   }
+  else
+  {
+    // Rollover happens on the first block past MAX_FILESIZE, leave room for it
+    preAllocateFile(dataFile, MAX_FILESIZE + SIZE);
+  }
   
   return dataFile;
 
 } 
 
 /**
- * @brief A method to write a log message to the SD card
+ * @brief Create a new data file and keep it open for appends
+ * @details The file size is tracked in RAM from here on so that appends never
+ *          have to look the file up or stat it again
+ * 
+ * @param time The current unix timestamp, used to name the file
+ * @return Whether or not the file was opened
+ */
+bool SD_Data :: openDataFile(uint32_t time)
+{
+    closeDataFile();
+
+    // Open the catalog first, a catalog rebuilt from /Data must not already hold the new file
+    bool catalogOpen = catalog.begin(true);
+
+    dataFile = createFile(time);
+    sdBus.setAppending(SD_BUS_DATA, DataFilePath.c_str());
+    sdBus.countOpen();
+    dataFileSize = 0;
+    flushedSize = 0;
+    unsyncedRecords = 0;
+
+    // Add the file to the catalog now so it can be found even if it is never closed
+    catalogEntry = CatalogEntry();
+    catalogEntry.nameTime = time;
+    catalogEntry.firstTime = time;
+    catalogEntry.format = DATA_FILE_FORMAT;
+    if (catalogOpen)
+    {
+        catalogIndex = catalog.size();
+        updateCatalog(true);
+    }
+
+#ifdef SD_BINARY_LOG
+    blockCrc = 0;
+    blockUnits = 0;
+    blockSequence = 0;
+
+    BinaryFileHeader header = {};
+    header.magic = BIN_MAGIC;
+    header.version = BIN_VERSION;
+    header.unitSize = BIN_UNIT_SIZE;
+    header.createTime = time;
+    header.sectorSize = BIN_SECTOR_SIZE;
+    writeUnit(&header);
+#endif
+
+    return dataFile.isOpen();
+}
+
+/**
+ * @brief Append a sample to the open data file
+ * @details Rolls over to a new file once MAX_FILESIZE is reached and syncs the
+ *          file every SD_SYNC_RECORDS samples. If the file was closed the
+ *          current file is reopened for append
+ * 
+ * @param distance The distance measured by the sensor
+ * @param unixTime The unix timestamp for when the data was recorded
+ * @param batteryVoltage The battery voltage
+ * @param solarVoltage Voltage of solar panel
+ */
+void SD_Data :: appendData(int32_t distance, uint32_t unixTime, float batteryVoltage, float solarVoltage)
+{
+    if (!dataFile.isOpen())
+    {
+        if (DataFilePath.length() == 0 || !dataFile.open(DataFilePath.c_str(), O_RDWR | O_CREAT | O_APPEND))
+        {
+            Serial.println("Data file not open, creating new file");
+            if (!openDataFile(unixTime)) return;
+        }
+        else
+        {
+            sdBus.countOpen();
+            dataFileSize = dataFile.fileSize();
+            flushedSize = dataFileSize;
+            unsyncedRecords = 0;
+            blockCrc = 0;
+            blockUnits = 0;
+            updateCatalog(true);
+        }
+    }
+
+    // Roll over to a new file without going back to the card for the size
+    if (dataFileSize >= MAX_FILESIZE)
+    {
+        if (!openDataFile(unixTime)) return;
+    }
+
+#ifdef SD_BINARY_LOG
+    writeRecord(distance, unixTime, batteryVoltage, solarVoltage);
+#else
+    writeData(distance, unixTime, batteryVoltage, solarVoltage);
+#endif
+
+    // Keep firstTime no older than the name so the catalog stays sorted
+    if (catalogEntry.records++ == 0 && unixTime > catalogEntry.firstTime)
+    {
+        catalogEntry.firstTime = unixTime;
+    }
+    catalogEntry.lastTime = unixTime;
+
+    if (++unsyncedRecords >= SD_SYNC_RECORDS)
+    {
+        syncData();
+    }
+}
+
+/**
+ * @brief Flush the open data file to the card
+ * @details Unless partial is set only whole sectors leave the staging buffer,
+ *          the partial sector at the end stays in RAM until the file is closed.
+ *          Writing it costs a read-modify-write of that sector once it fills.
+ * 
+ * @param partial Whether to also write the last, incomplete sector
+ */
+void SD_Data :: syncData(bool partial)
+{
+    if (dataFile.isOpen())
+    {
+        flushStage(partial);
+        sdBus.sync(dataFile);
+    }
+    unsyncedRecords = 0;
+}
+
+/**
+ * @brief A method to start a new data file so the current one can be read
+ * @details Readers stay away from the file being appended to, this hands
+ *          them every sample so far. Nothing happens if the file is empty, or
+ *          was started this second since the new one would get its name.
+ *
+ * @param time The current unix timestamp, used to name the new file
+ * @return Whether or not a new file was started
+ */
+bool SD_Data :: rolloverDataFile(uint32_t time)
+{
+    if (!dataFile.isOpen() || catalogEntry.records == 0 || time <= catalogEntry.nameTime) return false;
+
+    return openDataFile(time);
+}
+
+/**
+ * @brief Close the open data file
+ * 
+ */
+void SD_Data :: closeDataFile()
+{
+    if (dataFile.isOpen())
+    {
+#ifdef SD_BINARY_LOG
+        // Seal the last partial block so the tail of the file can be checked too
+        if (blockUnits > 0) writeBlockTrailer();
+#endif
+        flushStage(true);
+        closeFile(dataFile);
+        updateCatalog(false);
+    }
+    unsyncedRecords = 0;
+    stageLength = 0;
+}
+
+/**
+ * @brief Create a new GNSS file and keep it open for appends
+ * 
+ * @return Whether or not the file was opened
+ */
+bool SD_Data :: openGNSSFile()
+{
+    closeGNSSFile();
+
+    gnssFile = createGNSSFile();
+    sdBus.setAppending(SD_BUS_GNSS, GNSSFilePath.c_str());
+    sdBus.countOpen();
+    gnssFileSize = 0;
+
+    return gnssFile.isOpen();
+}
+
+/**
+ * @brief Close the open GNSS file
+ * 
+ */
+void SD_Data :: closeGNSSFile()
+{
+    closeFile(gnssFile);
+}
+
+/**
+ * @brief A method to reserve a contiguous extent for a new file
+ * @details Clusters are allocated once up front instead of one at a time at
+ *          every cluster boundary while logging. Only does anything when
+ *          SD_PREALLOCATE is defined, and falls back to normal growth when the
+ *          card has no contiguous run of free clusters that long.
+ * 
+ * @param file A newly created, empty file
+ * @param length The number of bytes to reserve
+ */
+void SD_Data :: preAllocateFile(ExFile &file, uint32_t length)
+{
+#ifdef SD_PREALLOCATE
+    if (!file.preAllocate(length))
+    {
+        Serial.println("SD preallocation failed, file will grow by cluster");
+    }
+#endif
+}
+
+/**
+ * @brief A method to trim a file to its real length and close it
+ * @details Files are only ever appended to, so everything past the end of
+ *          the data is unused preallocation. The end is the file size, not the
+ *          current position, a file reopened with O_APPEND sits at 0 until it
+ *          is first written.
+ * 
+ * @param file The file to close
+ */
+void SD_Data :: closeFile(ExFile &file)
+{
+    if (!file.isOpen()) return;
+
+#ifdef SD_PREALLOCATE
+    file.truncate(file.fileSize());
+#endif
+    file.close();
+}
+
+/**
+ * @brief A method to write the open data file's catalog entry
+ * @details Called when the file is created, reopened and closed, not on
+ *          every sample, so the entry of a file that was never closed only
+ *          shows where the file starts
+ * 
+ * @param open Whether the file is still being written to
+ */
+void SD_Data :: updateCatalog(bool open)
+{
+    catalogEntry.bytes = dataFileSize;
+    if (open)
+    {
+        catalogEntry.flags |= CATALOG_OPEN;
+    }
+    else
+    {
+        catalogEntry.flags &= ~CATALOG_OPEN;
+    }
+
+    if (!catalog.begin(true) || !catalog.write(catalogIndex, catalogEntry))
+    {
+        Serial.println("Failed to update data catalog");
+    }
+}
+
+/**
+ * @brief A method to add bytes to the staging buffer
+ * @details The buffer is written out as soon as it fills up
+ * 
+ * @param data The bytes to add
+ * @param length The number of bytes to add
+ */
+void SD_Data :: stageBytes(const void* data, size_t length)
+{
+    if (!dataFile.isOpen()) return;
+
+    const uint8_t* bytes = (const uint8_t*) data;
+
+    while (length > 0)
+    {
+        size_t chunk = SD_STAGE_SIZE - stageLength;
+        if (chunk > length) chunk = length;
+
+        memcpy(stage + stageLength, bytes, chunk);
+        stageLength += chunk;
+        dataFileSize += chunk;
+        bytes += chunk;
+        length -= chunk;
+
+        if (stageLength == SD_STAGE_SIZE)
+        {
+            flushStage(false);
+        }
+    }
+}
+
+/**
+ * @brief A method to write the staging buffer to the card
+ * @details Unless partial is set, only the bytes that end on a sector boundary
+ *          of the file are written so the card never has to read-modify-write
+ *          a sector. Whatever is left over is kept for the next flush.
  * 
- * @param unixTime The unix timestamp
- * @param wakeCounter The number of times the MCU has woken from deep sleep
- * @param latitude The latitude as measured by the GPS
- * @param longitude The longitude as measured by the GPS
- * @param altitude The altitude as measured by the GPS
+ * @param partial Whether to also write the last, incomplete sector
  */
-void SD_Data :: writeLog(uint32_t unixTime, uint32_t wakeCounter, float latitude, float longitude, float altitude)
+void SD_Data :: flushStage(bool partial)
 {
-    //Open log file and write to it
-    ExFile logFile = SD.open("/logFile.txt", O_RDWR | O_CREAT | O_TRUNC);
-    if(!logFile) return;
+    if (stageLength == 0 || !dataFile.isOpen()) return;
 
-    if (logFile.fileSize() == 0) {
-        logFile.println("Wake Count, UNIX Time (GMT), Latitude (decimal degrees), Longitude (decimal degrees), Altitude (meters above MSL)");
+    size_t length = stageLength;
+    if (!partial)
+    {
+        // Fill up the sector a previous partial flush left open, then whole sectors
+        size_t head = (SD_SECTOR_SIZE - (flushedSize % SD_SECTOR_SIZE)) % SD_SECTOR_SIZE;
+        if (length < head) return;
+        length = head + ((length - head) / SD_SECTOR_SIZE) * SD_SECTOR_SIZE;
+        if (length == 0) return;
     }
-    logFile.printf("%u, %u, %0.5f, %0.5f, %0.2f\n", wakeCounter, unixTime, latitude, longitude, altitude);
-    logFile.close();
+
+    sdBus.write(dataFile, stage, length);
+    flushedSize += length;
+
+    stageLength -= length;
+    memmove(stage, stage + length, stageLength);
 }
 
 /**
@@ -175,34 +476,122 @@ void SD_Data :: writeLog(uint32_t unixTime, uint32_t wakeCounter, float latitude
  * @param data_file A reference to the data file to be written to
  * @param distance The distance measured by the SONAR sensor
  * @param unixTime The unix timestamp for when the data was recorded
- * @param temperature The current temperature measured by the temperature and humidity sensor
- * @param humidity The current humidity measured by the temperature and humidity sensor
+ * @param batteryVoltage The battery voltage
+ * @param solarVoltage Voltage of solar panel
+ * @return The number of bytes written
+ */
+void SD_Data :: writeData(int32_t distance, uint32_t unixTime, float batteryVoltage, float solarVoltage)
+{
+    char line[48];
+    int len = snprintf(line, sizeof(line), "%u, %d, %0.2f, %0.2f\n", unixTime, distance, batteryVoltage, solarVoltage);
+    if (len < 0) return;
+    if ((size_t) len >= sizeof(line)) len = sizeof(line) - 1;
+
+    stageBytes(line, len);
+}
+
+/**
+ * @brief A method to write one binary sample to the open data file
+ * 
+ * @param distance The distance measured by the sensor
+ * @param unixTime The unix timestamp for when the data was recorded
+ * @param batteryVoltage The battery voltage
  * @param solarVoltage Voltage of solar panel
- * @return sensorData An object containing all of the data
  */
-void SD_Data :: writeData(ExFile &dataFile, int32_t distance, uint32_t unixTime, float batteryVoltage, float solarVoltage)
+void SD_Data :: writeRecord(int32_t distance, uint32_t unixTime, float batteryVoltage, float solarVoltage)
 {
-    dataFile.print(unixTime);
-    dataFile.printf(", %d, %0.2f, %0.2f, %0.2f, %0.2f\n", distance, batteryVoltage, solarVoltage);
+    SampleRecord record;
+    record.time = unixTime;
+    record.distance = distance;
+    record.battery = batteryVoltage;
+    record.batteryPercent = solarVoltage;
+    writeUnit(&record);
+}
+
+/**
+ * @brief A method to write one binary unit to the open data file
+ * @details The last unit of every sector is taken by a block trailer, so one
+ *          is written first whenever the unit would otherwise land there
+ * 
+ * @param unit The BIN_UNIT_SIZE bytes to write
+ */
+void SD_Data :: writeUnit(const void* unit)
+{
+    if (((dataFileSize + BIN_UNIT_SIZE) % BIN_SECTOR_SIZE) == 0)
+    {
+        writeBlockTrailer();
+    }
+
+    blockCrc = crc32Update(blockCrc, unit, BIN_UNIT_SIZE);
+    blockUnits++;
+    stageBytes(unit, BIN_UNIT_SIZE);
+}
+
+/**
+ * @brief A method to close the current binary block with its CRC
+ * @details A trailer is written even for an empty block when it is needed to
+ *          fill the last unit of a sector
+ * 
+ */
+void SD_Data :: writeBlockTrailer()
+{
+    BlockTrailer trailer = {};
+    trailer.marker = BIN_TRAILER_MARKER;
+    trailer.units = blockUnits;
+    trailer.crc = blockCrc;
+    trailer.sequence = blockSequence++;
+    stageBytes(&trailer, BIN_UNIT_SIZE);
+
+    blockCrc = 0;
+    blockUnits = 0;
 }
 
 /**
  * @brief A method to take a write GNSS data to the SD card
+ * @details Appends to the open GNSS file, rolling over to a new file once
+ *          MAX_FILESIZE is reached
  * 
- * @param data_file A reference to the data file to be written to
  * @param buffer A reference to the block of data to be written to the .ubx file
+ * @param length The number of bytes in the block
  */
-void SD_Data :: writeGNSSData(ExFile &dataFile, uint8_t buffer[SIZE])
+void SD_Data :: writeGNSSData(const uint8_t* buffer, size_t length)
 {
-    dataFile.write(buffer, SIZE);
+    if (!gnssFile.isOpen())
+    {
+        if (GNSSFilePath.length() == 0 || !gnssFile.open(GNSSFilePath.c_str(), O_RDWR | O_CREAT | O_APPEND))
+        {
+            if (!openGNSSFile()) return;
+        }
+        else
+        {
+            sdBus.countOpen();
+            gnssFileSize = gnssFile.fileSize();
+        }
+    }
+
+    // Roll over to a new file without going back to the card for the size
+    if (gnssFileSize >= MAX_FILESIZE)
+    {
+        Serial.println("GNSS file too large, creating new file");
+        if (!openGNSSFile()) return;
+    }
+
+    gnssFileSize += sdBus.write(gnssFile, buffer, length);
 }
 
 /**
- * @brief A method to close the current file and put the device to sleep
+ * @brief A method to close the open files and put the device to sleep
  * 
- * @param dataFile The file to close
  */
-void SD_Data :: sleep(ExFile &dataFile)
+void SD_Data :: sleep()
 {
-    dataFile.close();
-}
\ No newline at end of file
+    closeDataFile();
+    closeGNSSFile();
+    catalog.end();
+    sdBus.setAppending(SD_BUS_DATA, NULL);
+    sdBus.setAppending(SD_BUS_GNSS, NULL);
+
+#ifdef SD_STATS
+    sdBus.printStats(Serial);
+#endif
+}
@@ -8,12 +8,27 @@
  * 
  */
 
+#ifndef SD_DATA_H
+#define SD_DATA_H
+
 #include <Arduino.h>
 #include <SdFat.h>
 #include <utility>
 #include "setup.h"
+#include "sdRecord.h"
+#include "waterSenseLibs/dataCatalog/dataCatalog.h"
+#include "sdBus.h"
 
 #define SIZE sdWriteSize
+#define SD_STAGE_SIZE (SD_STAGE_SECTORS * SD_SECTOR_SIZE) ///< Size of the sample staging buffer in bytes
+
+#ifdef SD_BINARY_LOG
+    #define DATA_FILE_EXT ".bin" ///< Extension of the sample files
+    #define DATA_FILE_FORMAT CATALOG_BINARY ///< Format of the sample files in the catalog
+#else
+    #define DATA_FILE_EXT ".txt" ///< Extension of the sample files
+    #define DATA_FILE_FORMAT CATALOG_CSV ///< Format of the sample files in the catalog
+#endif
 
 extern SdFat SD;
 class SD_Data
@@ -24,6 +39,29 @@ class SD_Data
         //gpio_num_t LED = GPIO_NUM_2;
         String GNSSFilePath = "";
         String DataFilePath = "";
+        ExFile dataFile; ///< The data file, kept open between samples
+        uint32_t dataFileSize = 0; ///< Size of the open data file in bytes, tracked in RAM
+        uint32_t flushedSize = 0; ///< Bytes of the open data file that have been handed to the card
+        uint8_t stage[SD_STAGE_SIZE]; ///< Samples waiting to be written to the card in whole sectors
+        uint16_t stageLength = 0; ///< Number of bytes waiting in the staging buffer
+        uint16_t unsyncedRecords = 0; ///< Records appended since the data file was last synced
+        ExFile gnssFile; ///< The GNSS file, kept open between blocks
+        uint32_t gnssFileSize = 0; ///< Size of the open GNSS file in bytes, tracked in RAM
+        uint32_t blockCrc = 0; ///< CRC32 of the binary units written since the last trailer
+        uint16_t blockUnits = 0; ///< Number of binary units written since the last trailer
+        uint32_t blockSequence = 0; ///< Index of the next block trailer in the data file
+        DataCatalog catalog; ///< The index of data files
+        CatalogEntry catalogEntry; ///< The catalog entry of the open data file
+        uint32_t catalogIndex = 0; ///< Where catalogEntry is in the catalog
+
+        void writeUnit(const void* unit); ///< A method to write one binary unit to the data file
+        void writeBlockTrailer(void); ///< A method to close the current binary block with its CRC
+        void writeRecord(int32_t distance, uint32_t unixTime, float batteryVoltage, float solarVoltage); ///< A method to write a binary sample
+        void stageBytes(const void* data, size_t length); ///< A method to add bytes to the staging buffer
+        void flushStage(bool partial); ///< A method to write the staging buffer to the card
+        void preAllocateFile(ExFile &file, uint32_t length); ///< A method to reserve a contiguous extent for a new file
+        void closeFile(ExFile &file); ///< A method to trim a file to its real length and close it
+        void updateCatalog(bool open); ///< A method to write the open data file's catalog entry
 
     public:
         // Public data
@@ -42,14 +80,34 @@ class SD_Data
         // A method to write raw satellite data to .ubx files
         ExFile createGNSSFile();
 
-        /// A method to write a log message
-        void writeLog(uint32_t unixTime, uint32_t wakeCounter, float latitude, float longitude, float altitude);
+        /// A method to create a new data file and keep it open for appends
+        bool openDataFile(uint32_t time);
+
+        /// A method to start a new data file so the current one can be read
+        bool rolloverDataFile(uint32_t time);
+
+        /// A method to append a sample to the open data file
+        void appendData(int32_t distance, uint32_t unixTime, float batteryVoltage, float solarVoltage);
+
+        /// A method to flush the open data file to the card
+        void syncData(bool partial = false);
+
+        /// A method to close the open data file
+        void closeDataFile(void);
+
+        /// A method to create a new GNSS file and keep it open for appends
+        bool openGNSSFile(void);
+
+        /// A method to close the open GNSS file
+        void closeGNSSFile(void);
 
         /// A method to write data to the sd card
-        void writeData(ExFile &data_file, int32_t distance, uint32_t unixTime, float batteryVoltage, float solarVoltage);
+        void writeData(int32_t distance, uint32_t unixTime, float batteryVoltage, float solarVoltage);
 
         /// A method to write GNSS data to SD card
-        void writeGNSSData(ExFile &dataFile, uint8_t buffer[SIZE]);
+        void writeGNSSData(const uint8_t* buffer, size_t length);
+
+        void sleep(void); ///< A method to close the open files and put the device to sleep
+};
 
-        void sleep(ExFile &dataFile); ///< A method to close the current file and put the device to sleep
-};
\ No newline at end of file
+#endif //SD_DATA_H
@@ -0,0 +1,72 @@
+/**
+ * @file sdRecord.h
+ * @brief Layout of the binary sample files written by SD_Data
+ * @details A binary data file is a sequence of 16 byte little endian units. The
+ *          first unit is a BinaryFileHeader and every following unit is either a
+ *          SampleRecord or a BlockTrailer. A trailer holds the CRC32 of every
+ *          unit written since the previous trailer (the header included). One
+ *          is written in the last unit of every 512 byte sector and one more
+ *          whenever the file is closed, so a damaged sector only loses the
+ *          samples inside it. tools/wsbin2csv.py converts these files to CSV.
+ * @version 0.1
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#ifndef SD_RECORD_H
+#define SD_RECORD_H
+
+#include <Arduino.h>
+
+#define BIN_MAGIC 0x4C425357UL ///< "WSBL" read as a little endian word
+#define BIN_VERSION 1 ///< Bumped whenever the layout below changes
+#define BIN_UNIT_SIZE 16 ///< Size of every header, record and trailer in bytes
+#define BIN_SECTOR_SIZE 512 ///< A trailer fills the last unit of each sector
+#define BIN_TRAILER_MARKER 0xFFFFFFFFUL ///< Time field value that marks a trailer
+
+/**
+ * @brief The first unit of every binary data file
+ * 
+ */
+struct __attribute__((packed)) BinaryFileHeader
+{
+    uint32_t magic; ///< Always BIN_MAGIC
+    uint16_t version; ///< Always BIN_VERSION
+    uint16_t unitSize; ///< Always BIN_UNIT_SIZE
+    uint32_t createTime; ///< Unix time the file was created at
+    uint16_t sectorSize; ///< Always BIN_SECTOR_SIZE
+    uint16_t reserved;
+};
+
+/**
+ * @brief One sample, stored exactly as it was measured
+ * 
+ */
+struct __attribute__((packed)) SampleRecord
+{
+    uint32_t time; ///< Unix time (GMT) of the sample
+    int32_t distance; ///< Distance in mm
+    float battery; ///< Battery voltage in V
+    float batteryPercent; ///< Battery charge in %
+};
+
+/**
+ * @brief Closes a block of units with their CRC32
+ * 
+ */
+struct __attribute__((packed)) BlockTrailer
+{
+    uint32_t marker; ///< Always BIN_TRAILER_MARKER
+    uint16_t units; ///< Number of units covered by this trailer
+    uint16_t reserved;
+    uint32_t crc; ///< CRC32 of the covered units
+    uint32_t sequence; ///< Index of this block within the file
+};
+
+static_assert(sizeof(BinaryFileHeader) == BIN_UNIT_SIZE, "binary header must be one unit");
+static_assert(sizeof(SampleRecord) == BIN_UNIT_SIZE, "sample record must be one unit");
+static_assert(sizeof(BlockTrailer) == BIN_UNIT_SIZE, "block trailer must be one unit");
+
+#endif //SD_RECORD_H
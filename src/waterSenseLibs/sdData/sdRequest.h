@@ -0,0 +1,52 @@
+/**
+ * @file sdRequest.h
+ * @brief Requests other tasks send to the SD task through the sdRequests queue
+ * @details The SD task sleeps on the queue and handles requests strictly in the
+ *          order they were sent, so e.g. every GNSS block sent before SD_GNSS_END
+ *          is on the card before the GNSS file is closed.
+ * @version 0.1
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#ifndef SD_REQUEST_H
+#define SD_REQUEST_H
+
+#include <Arduino.h>
+#include "sdRecord.h"
+#include "waterSenseLibs/eventLog/eventLog.h"
+#include "waterSenseLibs/gnssBuffer/gnssBuffer.h"
+
+/**
+ * @brief What the SD task is being asked to do
+ * 
+ */
+enum SDRequestType : uint8_t
+{
+    SD_SAMPLE, ///< Append sample to the data file
+    SD_GNSS_BLOCK, ///< Append gnss to the GNSS file, then release its buffer
+    SD_GNSS_END, ///< No more GNSS blocks are coming this wake
+    SD_EVENT, ///< Append event to the event log
+    SD_FLUSH, ///< Push everything written so far out to the card
+    SD_SLEEP, ///< Close all files once the GNSS stream has ended, then report ready to sleep
+    SD_ROLLOVER ///< Start a new data file so the current one can be read, then set FLAG_SD_ROLLOVER_DONE
+};
+
+/**
+ * @brief One request for the SD task
+ * 
+ */
+struct SDRequest
+{
+    SDRequestType type; ///< Which of the members below is valid, if any
+    union
+    {
+        SampleRecord sample; ///< Valid for SD_SAMPLE
+        GNSSBlock gnss; ///< Valid for SD_GNSS_BLOCK
+        EventRecord event; ///< Valid for SD_EVENT
+    };
+};
+
+#endif //SD_REQUEST_H
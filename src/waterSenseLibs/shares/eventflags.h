@@ -0,0 +1,173 @@
+/**
+ * @file eventflags.h
+ * @brief A set of named flags tasks can block on until they are set
+ * @details A @c Share<bool> flag can only be polled, so a task waiting for
+ *          one wakes up every period to find out whether anything changed.
+ *          An @c EventFlags holds up to 24 flags in a FreeRTOS event group.
+ *          A task waiting for some of them to be set sleeps in the kernel and
+ *          is woken the moment the last one it needs is set, or when its
+ *          timeout runs out.
+ *
+ *          The flags are named by an enum of single bit values, so a set of
+ *          one group's flags cannot be handed to another group by mistake.
+ *          The enum needs an @c operator| to combine flags; see
+ *          @c TaskFlag in sharedData.h.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef _EVENTFLAGS_H_
+#define _EVENTFLAGS_H_
+
+#include "baseshare.h"
+#ifdef ESP32
+    #include "freertos/event_groups.h"
+#elif (defined STM32F4xx || defined STM32L4xx)
+    #include "FreeRTOS.h"
+    #include "event_groups.h"
+#endif
+
+
+/** @brief   Class for a group of flags which tasks can wait on.
+ *  @details Usage:
+ *           @code
+ *           EventFlags<TaskFlag> taskFlags ("Task Flags");
+ *           ...
+ *           taskFlags.set (FLAG_WAKE_READY);                  // In one task
+ *           ...
+ *           if (taskFlags.wait_all (FLAG_WAKE_READY, portMAX_DELAY))
+ *           {                                                  // In another
+ *               ...
+ *           }
+ *           @endcode
+ *           Every flag starts out clear.
+ */
+template <class FlagType> class EventFlags : public BaseShare
+{
+protected:
+    /// The FreeRTOS event group which holds the flags
+    EventGroupHandle_t group;
+
+public:
+    /** @brief   Construct a group of flags, all clear.
+     *  @param   p_name A name to be shown in the list of task shares
+     *           (default @c NULL)
+     */
+    EventFlags (const char* p_name = NULL) : BaseShare (p_name)
+    {
+        group = xEventGroupCreate ();
+    }
+
+    /** @brief   Set some flags, waking any task whose wait they complete.
+     *  @param   flags The flags to set
+     */
+    void set (FlagType flags)
+    {
+        xEventGroupSetBits (group, (EventBits_t) flags);
+    }
+
+    /** @brief   Set some flags from within an ISR.
+     *  @details The kernel finishes setting them in the timer task. It must
+     *           only be called from within an interrupt service routine.
+     *  @param   flags The flags to set
+     */
+    void ISR_set (FlagType flags)
+    {
+        BaseType_t wake_up = pdFALSE;
+        xEventGroupSetBitsFromISR (group, (EventBits_t) flags, &wake_up);
+        portYIELD_FROM_ISR (wake_up);
+    }
+
+    /** @brief   Clear some flags.
+     *  @param   flags The flags to clear
+     */
+    void clear (FlagType flags)
+    {
+        xEventGroupClearBits (group, (EventBits_t) flags);
+    }
+
+    /** @brief   Set or clear some flags.
+     *  @param   flags The flags to change
+     *  @param   value @c true to set them, @c false to clear them
+     */
+    void put (FlagType flags, bool value)
+    {
+        if (value)
+        {
+            set (flags);
+        }
+        else
+        {
+            clear (flags);
+        }
+    }
+
+    /** @brief   Get every flag which is set right now.
+     *  @returns The set flags, combined
+     */
+    FlagType get (void)
+    {
+        return (FlagType) xEventGroupGetBits (group);
+    }
+
+    /** @brief   Check whether some flags are all set right now.
+     *  @param   flags The flags to check
+     *  @returns @c true if every one of them is set
+     */
+    bool is_set (FlagType flags)
+    {
+        return (xEventGroupGetBits (group) & (EventBits_t) flags) == (EventBits_t) flags;
+    }
+
+    /** @brief   Wait until some flags are all set.
+     *  @param   flags The flags to wait for
+     *  @param   timeout The most ticks to wait, @c portMAX_DELAY for ever
+     *  @param   clear_on_exit Whether to clear the flags when they were all
+     *           set, in one step with the wait (default @c false)
+     *  @returns @c true if every one of them was set, @c false on a timeout
+     */
+    bool wait_all (FlagType flags, TickType_t timeout, bool clear_on_exit = false)
+    {
+        EventBits_t bits = xEventGroupWaitBits (group, (EventBits_t) flags,
+                                                clear_on_exit ? pdTRUE : pdFALSE,
+                                                pdTRUE, timeout);
+        return (bits & (EventBits_t) flags) == (EventBits_t) flags;
+    }
+
+    /** @brief   Wait until at least one of some flags is set.
+     *  @param   flags The flags to wait for
+     *  @param   timeout The most ticks to wait, @c portMAX_DELAY for ever
+     *  @param   clear_on_exit Whether to clear the flags which were set, in
+     *           one step with the wait (default @c false)
+     *  @returns Which of the flags were set, none on a timeout
+     */
+    FlagType wait_any (FlagType flags, TickType_t timeout, bool clear_on_exit = false)
+    {
+        EventBits_t bits = xEventGroupWaitBits (group, (EventBits_t) flags,
+                                                clear_on_exit ? pdTRUE : pdFALSE,
+                                                pdFALSE, timeout);
+        return (FlagType) (bits & (EventBits_t) flags);
+    }
+
+    /** @brief   Print the name and type of this group of flags.
+     *  @details Formatted like other shares, then asks the next share in the
+     *           list to print its information too.
+     *  @param   printer Reference to a serial device on which to print the
+     *           status
+     */
+    void print_in_list (Print& printer)
+    {
+        printer.printf ("%-16sflags\t", name);
+
+        if (p_next != NULL)
+        {
+            p_next->print_in_list (printer);
+        }
+    }
+
+}; // class EventFlags<FlagType>
+
+#endif  // _EVENTFLAGS_H_
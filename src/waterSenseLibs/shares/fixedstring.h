@@ -0,0 +1,103 @@
+/**
+ * @file fixedstring.h
+ * @brief A string with its characters stored inside the object
+ * @details An Arduino @c String only holds a pointer to characters on the
+ *          heap, so copying one through a share copies the pointer and not
+ *          the text. A @c FixedString<N> holds up to N - 1 characters and the
+ *          terminating zero in a plain array. It is trivially copyable, so it
+ *          can be put in a @c Share or @c SnapshotShare and every reader gets
+ *          its own copy of the text. Nothing here allocates memory.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef _FIXEDSTRING_H_
+#define _FIXEDSTRING_H_
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/** @brief   A string of at most N - 1 characters kept in a fixed array.
+ *  @details Text which does not fit is cut short, always leaving the string
+ *           terminated.
+ */
+template <size_t N> struct FixedString
+{
+    static_assert (N > 0, "FixedString needs room for the terminating zero");
+
+    /// The characters, always zero terminated
+    char text[N];
+
+    /** @brief   Construct an empty string.
+     */
+    FixedString (void)
+    {
+        text[0] = '\0';
+    }
+
+    /** @brief   Construct a string holding a copy of some text.
+     *  @param   source The text to copy
+     */
+    FixedString (const char* source)
+    {
+        assign (source);
+    }
+
+    /** @brief   Replace the contents with a copy of some text.
+     *  @param   source The text to copy
+     *  @returns Whether all of the text fit
+     */
+    bool assign (const char* source)
+    {
+        size_t length = strnlen (source, N - 1);
+        memcpy (text, source, length);
+        text[length] = '\0';
+        return source[length] == '\0';
+    }
+
+    /** @brief   Replace the contents with @c printf() style formatted text.
+     *  @param   pattern The format string
+     *  @returns Whether all of the text fit
+     */
+    __attribute__ ((format (printf, 2, 3)))
+    bool format (const char* pattern, ...)
+    {
+        va_list args;
+        va_start (args, pattern);
+        int length = vsnprintf (text, N, pattern, args);
+        va_end (args);
+        return length >= 0 && (size_t) length < N;
+    }
+
+    /** @brief   Get the characters as a C string.
+     *  @returns A pointer to the zero terminated text
+     */
+    const char* c_str (void) const
+    {
+        return text;
+    }
+
+    /** @brief   Get the number of characters held.
+     *  @returns The length of the text, not counting the terminating zero
+     */
+    size_t length (void) const
+    {
+        return strlen (text);
+    }
+
+    /** @brief   Get the most characters the string can hold.
+     *  @returns N - 1
+     */
+    static size_t capacity (void)
+    {
+        return N - 1;
+    }
+};
+
+#endif  // _FIXEDSTRING_H_
@@ -0,0 +1,143 @@
+/**
+ * @file shareversion.h
+ * @brief Change notification for shares: versions, dropped updates, waiting
+ * @details Every @c put() to a share makes a new version of its data, counted
+ *          from 1; version 0 means nothing has been put yet. A reader keeps
+ *          the last version it saw and asks for the data only if there is a
+ *          newer one, or waits until there is. The versions it skipped on the
+ *          way are the updates it never saw, and are counted as dropped.
+ *
+ *          This replaces a data share paired with a "ready" flag, which a
+ *          reader can only poll and which hides how many updates it missed.
+ *
+ *          A waiting task is woken with its FreeRTOS task notification. Only
+ *          one task can wait on a share at a time, and it should not use its
+ *          task notification for anything else.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef _SHAREVERSION_H_
+#define _SHAREVERSION_H_
+
+#include <atomic>
+#include "baseshare.h"
+
+
+/** @brief   Keeps track of the task waiting for a share to change and of the
+ *           updates its readers dropped.
+ *  @details Each versioned share has one of these. The share keeps its own
+ *           version number together with its data; this class only compares
+ *           versions and wakes the waiter.
+ */
+class ShareVersion
+{
+protected:
+    /// The task waiting for a newer version, @c NULL if none is
+    std::atomic<TaskHandle_t> waiter;
+
+    /// Versions skipped by readers since the share was created
+    std::atomic<uint32_t> dropped_count;
+
+public:
+    /** @brief   Construct with no waiter and nothing dropped.
+     */
+    ShareVersion (void) : waiter (NULL), dropped_count (0)
+    {
+    }
+
+    /** @brief   Wake the waiting task, if any, after a new version was put.
+     *  @details May be used within an ISR or outside one.
+     */
+    void notify (void)
+    {
+        // Pairs with the fence in wait(), so either the waiter sees the new
+        // version or this sees the waiter
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+        TaskHandle_t task = waiter.load (std::memory_order_relaxed);
+        if (task == NULL)
+        {
+            return;
+        }
+
+        if (CHECK_IF_IN_ISR ())
+        {
+            BaseType_t wake_up = pdFALSE;
+            vTaskNotifyGiveFromISR (task, &wake_up);
+            portYIELD_FROM_ISR (wake_up);
+        }
+        else
+        {
+            xTaskNotifyGive (task);
+        }
+    }
+
+    /** @brief   Check whether a version is newer than the last one a reader
+     *           saw, and if so make it the last one.
+     *  @details Versions between the two are counted as dropped.
+     *  @param   version The version the reader has just read
+     *  @param   last_version The last version the reader saw, updated
+     *  @returns @c true if @c version is newer
+     */
+    bool accept (uint32_t version, uint32_t& last_version)
+    {
+        int32_t ahead = (int32_t) (version - last_version);
+        if (ahead <= 0)
+        {
+            return false;
+        }
+
+        if (ahead > 1)
+        {
+            dropped_count.fetch_add (ahead - 1, std::memory_order_relaxed);
+        }
+        last_version = version;
+        return true;
+    }
+
+    /** @brief   Wait until a share has a version newer than one a reader saw.
+     *  @param   share The share, which must have a @c version() method
+     *  @param   last_version The last version the reader saw
+     *  @param   timeout The most ticks to wait, @c portMAX_DELAY for ever
+     *  @returns @c true if there is a newer version, @c false on a timeout
+     */
+    template <class ShareType>
+    bool wait (ShareType& share, uint32_t last_version, TickType_t timeout)
+    {
+        TickType_t start = xTaskGetTickCount ();
+        waiter.store (xTaskGetCurrentTaskHandle (), std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+
+        bool changed;
+        while (!(changed = (int32_t) (share.version () - last_version) > 0))
+        {
+            TickType_t waited = xTaskGetTickCount () - start;
+            if (timeout != portMAX_DELAY && waited >= timeout)
+            {
+                break;
+            }
+
+            // A notification left over from an older put() only costs a
+            // trip around the loop
+            ulTaskNotifyTake (pdTRUE, (timeout == portMAX_DELAY) ? portMAX_DELAY
+                                                                 : timeout - waited);
+        }
+
+        waiter.store (NULL, std::memory_order_relaxed);
+        return changed;
+    }
+
+    /** @brief   Return how many versions readers skipped.
+     *  @returns The number of updates put but never read
+     */
+    uint32_t dropped (void)
+    {
+        return dropped_count.load (std::memory_order_relaxed);
+    }
+
+}; // class ShareVersion
+
+#endif  // _SHAREVERSION_H_
@@ -0,0 +1,236 @@
+/**
+ * @file snapshotshare.h
+ * @brief A share for a struct of related values, read as one consistent copy
+ * @details A @c Share holds one value; related values published through
+ *          separate shares can be read half from one update and half from
+ *          the next. A @c SnapshotShare holds a whole struct behind a sequence
+ *          lock. The writer makes the sequence number odd, copies the struct
+ *          in and makes it even again. A reader copies the struct out between
+ *          two reads of the sequence number and tries again if they differ
+ *          or were odd, so it never blocks the writer and never sees a mix.
+ *
+ *          The write is done inside a critical section, which keeps it from
+ *          being preempted on its own core. A reader only ever retries while
+ *          a write on the other core finishes copying, so readers do not need
+ *          to yield and may be ISR's.
+ *
+ *          Half the sequence number is the version of the data, so readers
+ *          can use @c get_if_newer() and @c wait_for_change() like they can
+ *          with a @c Share.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef _SNAPSHOTSHARE_H_
+#define _SNAPSHOTSHARE_H_
+
+#include <atomic>
+#include <type_traits>
+#include <string.h>
+#include "baseshare.h"
+#include "shareversion.h"
+
+
+/** @brief   Class for a struct to be shared between tasks as one snapshot.
+ *  @details Usage is the same as @c Share: @c put() publishes a whole struct
+ *           and @c get() returns a copy of the most recently published one.
+ *           To change a few fields the writer gets a copy, changes it and
+ *           puts it back; there should only be one task doing that.
+ *           @code
+ *           SnapshotShare<GNSSFix> gnssFix ("GNSS Fix");
+ *           ...
+ *           GNSSFix fix = gnssFix.get ();
+ *           fix.latitude = ...;
+ *           gnssFix.put (fix);
+ *           @endcode
+ *           The data starts out value-initialized, all zero for a plain
+ *           struct.
+ */
+template <class DataType> class SnapshotShare : public BaseShare
+{
+    static_assert (std::is_trivially_copyable<DataType>::value,
+                   "SnapshotShare data must be copyable with memcpy()");
+
+protected:
+    /// Even while the data is stable, odd while it is being written
+    std::atomic<uint32_t> sequence;
+
+    /// The most recently published data
+    DataType data;
+
+    /// Serializes writers and keeps a write from being preempted
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+    /// The reader waiting for a change and the updates readers dropped
+    ShareVersion changes;
+
+    /** @brief   Copy the data out along with its version.
+     *  @details Retries only while a write is in progress on the other core.
+     *  @param   recv_data A reference to the variable in which to put the copy
+     *  @returns The version of the copy
+     */
+    uint32_t read (DataType& recv_data)
+    {
+        while (true)
+        {
+            uint32_t start = sequence.load (std::memory_order_acquire);
+            if (start & 1)
+            {
+                continue;
+            }
+
+            memcpy (&recv_data, &data, sizeof (DataType));
+            std::atomic_thread_fence (std::memory_order_acquire);
+
+            if (sequence.load (std::memory_order_relaxed) == start)
+            {
+                return start / 2;
+            }
+        }
+    }
+
+public:
+    /** @brief   Construct a snapshot share.
+     *  @param   p_name A name to be shown in the list of task shares
+     *           (default @c NULL)
+     */
+    SnapshotShare (const char* p_name = NULL)
+        : BaseShare (p_name), sequence (0), data ()
+    {
+    }
+
+    /** @brief   Publish a whole struct.
+     *  @details May be used within an ISR or outside one.
+     *  @param   new_data The data which is to be published
+     */
+    void put (const DataType& new_data)
+    {
+        bool in_isr = CHECK_IF_IN_ISR ();
+        if (in_isr)
+        {
+            portENTER_CRITICAL_ISR (&mux);
+        }
+        else
+        {
+            portENTER_CRITICAL (&mux);
+        }
+
+        uint32_t start = sequence.load (std::memory_order_relaxed);
+        sequence.store (start + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_release);
+        memcpy (&data, &new_data, sizeof (DataType));
+        sequence.store (start + 2, std::memory_order_release);
+
+        if (in_isr)
+        {
+            portEXIT_CRITICAL_ISR (&mux);
+        }
+        else
+        {
+            portEXIT_CRITICAL (&mux);
+        }
+
+        changes.notify ();
+    }
+
+    /** @brief   Copy the most recently published struct into a variable.
+     *  @details Retries only while a write is in progress on the other core.
+     *           May be used within an ISR or outside one.
+     *  @param   recv_data A reference to the variable in which to put the copy
+     */
+    void get (DataType& recv_data)
+    {
+        read (recv_data);
+    }
+
+    /** @brief   Return a copy of the most recently published struct.
+     *  @returns A consistent copy of the data
+     */
+    DataType get (void)
+    {
+        DataType return_this;
+        get (return_this);
+        return return_this;
+    }
+
+    /** @brief   Return the version of the data in the share.
+     *  @returns The number of @c put()'s which have finished
+     */
+    uint32_t version (void)
+    {
+        return sequence.load (std::memory_order_acquire) / 2;
+    }
+
+    /** @brief   Copy the struct only if it is newer than a version already
+     *           seen.
+     *  @details Versions between the two are counted in @c dropped(). May be
+     *           used within an ISR or outside one.
+     *  @param   recv_data A reference to the variable in which to put the
+     *           copy, left alone if there is nothing newer
+     *  @param   last_version The version the reader last saw, updated to the
+     *           version copied
+     *  @returns @c true if a newer struct was copied
+     */
+    bool get_if_newer (DataType& recv_data, uint32_t& last_version)
+    {
+        if (version () == last_version)
+        {
+            return false;
+        }
+
+        DataType copy;
+        if (!changes.accept (read (copy), last_version))
+        {
+            return false;
+        }
+        recv_data = copy;
+        return true;
+    }
+
+    /** @brief   Wait for a struct newer than a version already seen, then copy
+     *           it.
+     *  @details Only one task at a time may wait for a share to change.
+     *  @param   recv_data A reference to the variable in which to put the
+     *           copy, left alone on a timeout
+     *  @param   last_version The version the reader last saw, updated to the
+     *           version copied
+     *  @param   timeout The most ticks to wait, @c portMAX_DELAY for ever
+     *  @returns @c true if a newer struct was copied, @c false on a timeout
+     */
+    bool wait_for_change (DataType& recv_data, uint32_t& last_version,
+                          TickType_t timeout)
+    {
+        return changes.wait (*this, last_version, timeout)
+               && get_if_newer (recv_data, last_version);
+    }
+
+    /** @brief   Return how many updates readers skipped.
+     *  @returns The number of versions put but never read
+     */
+    uint32_t dropped (void)
+    {
+        return changes.dropped ();
+    }
+
+    /** @brief   Print the name and type of this share.
+     *  @details Formatted like other shares, then asks the next share in the
+     *           list to print its information too.
+     *  @param   printer Reference to a serial device on which to print the
+     *           status
+     */
+    void print_in_list (Print& printer)
+    {
+        printer.printf ("%-16ssnapshot\t%u dropped\t", name, (unsigned) dropped ());
+
+        if (p_next != NULL)
+        {
+            p_next->print_in_list (printer);
+        }
+    }
+
+}; // class SnapshotShare<DataType>
+
+#endif  // _SNAPSHOTSHARE_H_
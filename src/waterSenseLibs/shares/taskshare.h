@@ -21,6 +21,10 @@
  *  @date 2020-Nov-18 JRR Critical sections not reliable; changed to a queue
  *  @date 2021-Sep-17 JRR Changed some @c put params from references to copies
  *  @date 2021-Sep-19 JRR Added overloads for @c get() which return values
+ *  @date 2026-Oct-17 Added a lock-free version for data of up to 4 bytes;
+ *                    @c >> now fills in its parameter
+ *  @date 2026-Oct-17 Added versions, @c get_if_newer() and 
+ *                    @c wait_for_change() so readers can see every update
  *
  *  @copyright This file is copyright 2014 -- 2021 by JR Ridgely and released 
  *    under the Lesser GNU Public License, version 2. It intended for 
@@ -41,12 +45,29 @@
 #ifndef _TASKSHARE_H_
 #define _TASKSHARE_H_
 
+#include <atomic>
+#include <type_traits>
+#include <string.h>
 #include "baseshare.h"                      // Base class for shared data items
+#include "shareversion.h"                   // Versions and change waiting
 #if (defined STM32F4xx || defined STM32L4xx)
     #include "FreeRTOS.h"                       // Main header for FreeRTOS
 #endif
 
 
+/** @brief   Decides whether a share of a type is kept in an atomic word.
+ *  @details Data which can be copied with @c memcpy() and fits in 32 bits is
+ *           held in a @c std::atomic<uint32_t>, which the ESP32 and STM32
+ *           read and write with single instructions. Anything bigger still
+ *           goes through a one-item queue.
+ */
+template <class DataType> struct ShareIsAtomic
+{
+    static const bool value = std::is_trivially_copyable<DataType>::value
+                              && sizeof (DataType) <= sizeof (uint32_t);
+};
+
+
 /** @brief   Class for data to be shared in a thread-safe manner between tasks.
  *  @details This class implements an item of data which can be shared between
  *           tasks without the risk of data corruption associated with global 
@@ -118,13 +139,89 @@
  *           ...
  *           my_share >> got_data;          // In receiving task
  *           @endcode
+ *
+ *           @b Seeing @b Every @b Update
+ *           A reader which must not miss updates, or must know how many it
+ *           missed, keeps the version of the data it last saw. Versions count
+ *           @c put()'s from 1. @c get_if_newer() only fills in the data if
+ *           there is a newer version, and @c wait_for_change() waits until
+ *           there is. Versions the reader skipped are added to @c dropped():
+ *           @code
+ *           uint32_t seen = 0;             ///< Last version read
+ *           ...
+ *           if (my_share.wait_for_change (got_data, seen, portMAX_DELAY))
+ *           {
+ *               ...                        // A new value in got_data
+ *           }
+ *           @endcode
+ *           Only one task at a time may wait for a share to change. 
+ *
+ *           Shares of small plain types such as @c bool, @c int32_t and
+ *           @c float use the lock-free version of this class below. It has
+ *           the same methods but makes no kernel calls to read the data. 
  */
-template <class DataType> class Share : public BaseShare
+template <class DataType, bool atomic = ShareIsAtomic<DataType>::value>
+class Share : public BaseShare
 {
 protected:
+    /// What the queue holds, the data and the version it is
+    struct Item
+    {
+        uint32_t version;                   ///< Version of the data
+        DataType data;                      ///< The data itself
+    };
+
     /// A queue is used to hold the data, as it's portable to different CPU's
     QueueHandle_t queue;
 
+    /// The version given to the most recent @c put()
+    std::atomic<uint32_t> latest;
+
+    /// Keeps versions in the queue in the order they were given out
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+    /// The reader waiting for a change and the updates readers dropped
+    ShareVersion changes;
+
+    /** @brief   Make the next version of the data and overwrite the queue 
+     *           with it.
+     *  @details Both happen in one critical section. Otherwise a writer 
+     *           preempted between the two could overwrite a newer version 
+     *           with its older one. The FromISR call does not block or yield
+     *           inside the critical section, @c put() yields afterwards.
+     *  @param   new_data The data which is to be written
+     *  @param   in_isr Whether this is running in an ISR
+     *  @returns Whether a task waiting for the first data was woken
+     */
+    BaseType_t overwrite (const DataType& new_data, bool in_isr)
+    {
+        BaseType_t wake_up = pdFALSE;
+        Item item;
+        item.data = new_data;
+        if (in_isr)
+        {
+            portENTER_CRITICAL_ISR (&mux);
+        }
+        else
+        {
+            portENTER_CRITICAL (&mux);
+        }
+
+        item.version = latest.load (std::memory_order_relaxed) + 1;
+        latest.store (item.version, std::memory_order_relaxed);
+        xQueueOverwriteFromISR (queue, &item, &wake_up);
+
+        if (in_isr)
+        {
+            portEXIT_CRITICAL_ISR (&mux);
+        }
+        else
+        {
+            portEXIT_CRITICAL (&mux);
+        }
+        return wake_up;
+    }
+
 public:
     /** @brief   Construct a shared data item.
      *  @details This constructor for a shared data item creates a queue in 
@@ -133,9 +230,9 @@ public:
      *  @param   p_name A name to be shown in the list of task shares 
      *           (default @c NULL)
      */
-    Share<DataType> (const char* p_name = NULL) : BaseShare (p_name)
+    Share (const char* p_name = NULL) : BaseShare (p_name), latest (0)
     {
-        queue = xQueueCreate (1, sizeof (DataType));
+        queue = xQueueCreate (1, sizeof (Item));
     }
 
     /** @brief   Put data into the shared data item.
@@ -144,7 +241,11 @@ public:
      */
     void put (DataType new_data)
     {
-        xQueueOverwrite (queue, &new_data);
+        if (overwrite (new_data, false))
+        {
+            taskYIELD ();
+        }
+        changes.notify ();
     }
 
     /** @brief   Put data into the shared data item from within an ISR.
@@ -155,8 +256,8 @@ public:
      */
     void ISR_put (DataType new_data)
     {
-        BaseType_t wake_up;
-        xQueueOverwriteFromISR (queue, &new_data, &wake_up);
+        portYIELD_FROM_ISR (overwrite (new_data, true));
+        changes.notify ();
     }
 
     /** @brief   Operator which inserts data into the share.
@@ -172,12 +273,11 @@ public:
     {
         if (CHECK_IF_IN_ISR ())
         {
-            BaseType_t wake_up;
-            xQueueOverwriteFromISR (queue, &new_data, &wake_up);
+            ISR_put (new_data);
         }
         else
         {
-            xQueueOverwrite (queue, &new_data);
+            put (new_data);
         }
     }
 
@@ -195,16 +295,15 @@ public:
      *  @param   put_here A reference to the variable in which to put received
      *           data
      */
-    void operator >> (DataType put_here)
+    void operator >> (DataType& put_here)
     {
         if (CHECK_IF_IN_ISR ())
         {
-            // Copy the data from the queue into the receiving variable
-            xQueuePeekFromISR (queue, &put_here);
+            ISR_get (put_here);
         }
         else
         {
-            xQueuePeek (queue, &put_here, portMAX_DELAY);
+            get (put_here);
         }
     }
 
@@ -220,7 +319,9 @@ public:
     void get (DataType& recv_data)
     {
         // Copy the data from the queue into the receiving variable
-        xQueuePeek (queue, &recv_data, portMAX_DELAY);
+        Item item;
+        xQueuePeek (queue, &item, portMAX_DELAY);
+        recv_data = item.data;
     }
 
     /** @brief   Read and return data from the shared data item.
@@ -235,7 +336,7 @@ public:
         DataType return_this;
     
         // Copy the data from the queue into the receiving variable
-        xQueuePeek (queue, &return_this, portMAX_DELAY);
+        get (return_this);
 
         return return_this;
     }
@@ -249,7 +350,9 @@ public:
      */
     void ISR_get (DataType& recv_data)
     {
-        xQueuePeekFromISR (queue, &recv_data);
+        Item item;
+        xQueuePeekFromISR (queue, &item);
+        recv_data = item.data;
     }
 
     /** @brief   Read and return data from the shared data item, from within an
@@ -263,16 +366,308 @@ public:
     DataType ISR_get (void)
     {
         DataType return_this;
-        xQueuePeekFromISR (queue, &return_this);
+        ISR_get (return_this);
         return return_this;
     }
 
+    /** @brief   Return the version of the data in the share.
+     *  @returns The number of the @c put() which wrote it, 0 if there was none
+     */
+    uint32_t version (void)
+    {
+        Item item;
+        if (xQueuePeek (queue, &item, 0) != pdTRUE)
+        {
+            return 0;
+        }
+        return item.version;
+    }
+
+    /** @brief   Read the data only if it is newer than a version already seen.
+     *  @details Versions between the two are counted in @c dropped(). 
+     *  @param   recv_data A reference to the variable in which to put the
+     *           data, left alone if there is nothing newer
+     *  @param   last_version The version the reader last saw, updated to the
+     *           version read
+     *  @returns @c true if newer data was read
+     */
+    bool get_if_newer (DataType& recv_data, uint32_t& last_version)
+    {
+        Item item;
+        if (xQueuePeek (queue, &item, 0) != pdTRUE
+            || !changes.accept (item.version, last_version))
+        {
+            return false;
+        }
+        recv_data = item.data;
+        return true;
+    }
+
+    /** @brief   Wait for data newer than a version already seen, then read it.
+     *  @details Only one task at a time may wait for a share to change. 
+     *  @param   recv_data A reference to the variable in which to put the
+     *           data, left alone on a timeout
+     *  @param   last_version The version the reader last saw, updated to the
+     *           version read
+     *  @param   timeout The most ticks to wait, @c portMAX_DELAY for ever
+     *  @returns @c true if newer data was read, @c false on a timeout
+     */
+    bool wait_for_change (DataType& recv_data, uint32_t& last_version,
+                          TickType_t timeout)
+    {
+        return changes.wait (*this, last_version, timeout)
+               && get_if_newer (recv_data, last_version);
+    }
+
+    /** @brief   Return how many updates readers skipped.
+     *  @returns The number of versions put but never read
+     */
+    uint32_t dropped (void)
+    {
+        return changes.dropped ();
+    }
+
     // Print the share's status within a list of all shares' statuses
     void print_in_list (Print& printer);
 
 }; // class TaskShare<DataType>
 
 
+/** @brief   Lock-free version of @c Share for data of up to 4 bytes.
+ *  @details The data is kept in one @c std::atomic<uint32_t>, so @c get() is
+ *           a single load, with no queue and no critical section. The same
+ *           code is safe in tasks and in ISR's; the @c ISR_ methods and the
+ *           @c << and @c >> operators are kept so the class can be used
+ *           exactly like the queue version. 
+ * 
+ *           The version is kept as a sequence number which @c put() makes odd
+ *           while it stores the data, in a short critical section, so
+ *           @c get_if_newer() reads a version and the data that goes with
+ *           it. Readers never lock. 
+ * 
+ *           The data starts out as all zero bits. Unlike the queue version,
+ *           @c get() before the first @c put() returns that instead of 
+ *           waiting for a @c put(). 
+ */
+template <class DataType> class Share<DataType, true> : public BaseShare
+{
+protected:
+    /// The bits of the most recent data
+    std::atomic<uint32_t> word;
+
+    /// Twice the version, odd while a @c put() is storing the data
+    std::atomic<uint32_t> sequence;
+
+    /// Serializes writers and keeps a write from being preempted
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+    /// The reader waiting for a change and the updates readers dropped
+    ShareVersion changes;
+
+    /** @brief   Pack data into the bits kept in the atomic word.
+     *  @param   data The data to be packed
+     *  @returns The data's bytes in the low bytes of a 32 bit word
+     */
+    static uint32_t pack (const DataType& data)
+    {
+        uint32_t bits = 0;
+        memcpy (&bits, &data, sizeof (DataType));
+        return bits;
+    }
+
+    /** @brief   Unpack data from the bits kept in the atomic word.
+     *  @param   bits The bits read from the atomic word
+     *  @returns The data packed into those bits
+     */
+    static DataType unpack (uint32_t bits)
+    {
+        DataType data;
+        memcpy (&data, &bits, sizeof (DataType));
+        return data;
+    }
+
+public:
+    /** @brief   Construct a shared data item.
+     *  @details The data is initialized to all zero bits. 
+     *  @param   p_name A name to be shown in the list of task shares 
+     *           (default @c NULL)
+     */
+    Share (const char* p_name = NULL)
+        : BaseShare (p_name), word (0), sequence (0)
+    {
+    }
+
+    /** @brief   Put data into the shared data item.
+     *  @details May be used within an ISR or outside one. 
+     *  @param   new_data The data which is to be written
+     */
+    void put (DataType new_data)
+    {
+        bool in_isr = CHECK_IF_IN_ISR ();
+        if (in_isr)
+        {
+            portENTER_CRITICAL_ISR (&mux);
+        }
+        else
+        {
+            portENTER_CRITICAL (&mux);
+        }
+
+        uint32_t start = sequence.load (std::memory_order_relaxed);
+        sequence.store (start + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_release);
+        word.store (pack (new_data), std::memory_order_relaxed);
+        sequence.store (start + 2, std::memory_order_release);
+
+        if (in_isr)
+        {
+            portEXIT_CRITICAL_ISR (&mux);
+        }
+        else
+        {
+            portEXIT_CRITICAL (&mux);
+        }
+
+        changes.notify ();
+    }
+
+    /** @brief   Put data into the shared data item from within an ISR.
+     *  @details The same as @c put(), which is safe within an ISR. 
+     *  @param   new_data The data to be written into the shared data item
+     */
+    void ISR_put (DataType new_data)
+    {
+        put (new_data);
+    }
+
+    /** @brief   Operator which inserts data into the share.
+     *  @details The same as @c put(), which is safe within an ISR. 
+     *  @param   new_data The data which is to be put into the share
+     */
+    void operator << (DataType new_data)
+    {
+        put (new_data);
+    }
+
+    /** @brief   Operator which reads data from the share into a variable.
+     *  @details The same as @c get(), which is safe within an ISR. 
+     *  @param   put_here A reference to the variable in which to put received
+     *           data
+     */
+    void operator >> (DataType& put_here)
+    {
+        put_here = get ();
+    }
+
+    /** @brief   Read data from the shared data item into a variable.
+     *  @param   recv_data A reference to the variable in which to put received
+     *           data
+     */
+    void get (DataType& recv_data)
+    {
+        recv_data = get ();
+    }
+
+    /** @brief   Read and return data from the shared data item.
+     *  @returns A copy of the most recent data
+     */
+    DataType get (void)
+    {
+        return unpack (word.load (std::memory_order_acquire));
+    }
+
+    /** @brief   Read data from the shared data item, from within an ISR.
+     *  @details The same as @c get(), which is safe within an ISR. 
+     *  @param   recv_data A reference to the variable in which to put received
+     *           data
+     */
+    void ISR_get (DataType& recv_data)
+    {
+        recv_data = get ();
+    }
+
+    /** @brief   Read and return data from the shared data item, from within an
+     *           ISR.
+     *  @details The same as @c get(), which is safe within an ISR. 
+     *  @returns A copy of the most recent data
+     */
+    DataType ISR_get (void)
+    {
+        return get ();
+    }
+
+    /** @brief   Return the version of the data in the share.
+     *  @returns The number of @c put()'s which have finished
+     */
+    uint32_t version (void)
+    {
+        return sequence.load (std::memory_order_acquire) / 2;
+    }
+
+    /** @brief   Read the data only if it is newer than a version already seen.
+     *  @details Versions between the two are counted in @c dropped(). May be
+     *           used within an ISR or outside one. 
+     *  @param   recv_data A reference to the variable in which to put the
+     *           data, left alone if there is nothing newer
+     *  @param   last_version The version the reader last saw, updated to the
+     *           version read
+     *  @returns @c true if newer data was read
+     */
+    bool get_if_newer (DataType& recv_data, uint32_t& last_version)
+    {
+        while (true)
+        {
+            uint32_t start = sequence.load (std::memory_order_acquire);
+            if (start & 1)
+            {
+                continue;
+            }
+
+            uint32_t bits = word.load (std::memory_order_relaxed);
+            std::atomic_thread_fence (std::memory_order_acquire);
+
+            if (sequence.load (std::memory_order_relaxed) == start)
+            {
+                if (!changes.accept (start / 2, last_version))
+                {
+                    return false;
+                }
+                recv_data = unpack (bits);
+                return true;
+            }
+        }
+    }
+
+    /** @brief   Wait for data newer than a version already seen, then read it.
+     *  @details Only one task at a time may wait for a share to change. 
+     *  @param   recv_data A reference to the variable in which to put the
+     *           data, left alone on a timeout
+     *  @param   last_version The version the reader last saw, updated to the
+     *           version read
+     *  @param   timeout The most ticks to wait, @c portMAX_DELAY for ever
+     *  @returns @c true if newer data was read, @c false on a timeout
+     */
+    bool wait_for_change (DataType& recv_data, uint32_t& last_version,
+                          TickType_t timeout)
+    {
+        return changes.wait (*this, last_version, timeout)
+               && get_if_newer (recv_data, last_version);
+    }
+
+    /** @brief   Return how many updates readers skipped.
+     *  @returns The number of versions put but never read
+     */
+    uint32_t dropped (void)
+    {
+        return changes.dropped ();
+    }
+
+    // Print the share's status within a list of all shares' statuses
+    void print_in_list (Print& printer);
+
+}; // class Share<DataType, true>
+
+
 /** @brief   Print the name and type (share) of this data item.
  *  @details This method prints the share's name and a word indicating that it
  *           is a shared data item, as opposed to a queue, formatted to match
@@ -281,11 +676,12 @@ public:
  *           shares for the next one and asks it to print its information too.
  *  @param   printer Reference to a serial device on which to print the status
  */
-template <class DataType>
-void Share<DataType>::print_in_list (Print& printer)
+template <class DataType, bool atomic>
+void Share<DataType, atomic>::print_in_list (Print& printer)
 {
-    // Print this task's name and pad it to 16 characters
-    printer.printf ("%-16sshare\t", name);
+    // Print this task's name and pad it to 16 characters, then how many
+    // updates readers have missed
+    printer.printf ("%-16sshare\t%u dropped\t", name, (unsigned) dropped ());
 
     // End the line
     // printer << endl;
@@ -297,4 +693,21 @@ void Share<DataType>::print_in_list (Print& printer)
     }
 }
 
+
+/** @brief   Print the name and type (share) of this data item.
+ *  @details Formatted like the queue version; the next share in the list is
+ *           asked to print its information too. 
+ *  @param   printer Reference to a serial device on which to print the status
+ */
+template <class DataType>
+void Share<DataType, true>::print_in_list (Print& printer)
+{
+    printer.printf ("%-16sshare\t%u dropped\t", name, (unsigned) dropped ());
+
+    if (p_next != NULL)
+    {
+        p_next->print_in_list (printer);
+    }
+}
+
 #endif  // _TASKSHARE_H_
@@ -0,0 +1,71 @@
+/**
+ * @file timeFormat.cpp
+ * @brief Readable timestamps written without allocating memory
+ * @version 0.1
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#include "timeFormat.h"
+
+/**
+ * @brief Write a number as a fixed count of decimal digits
+ * 
+ * @param out Where to write the digits
+ * @param value The number
+ * @param digits How many digits to write, with leading zeros
+ * @return A pointer just past the last digit
+ */
+static char* putDigits(char* out, uint32_t value, uint8_t digits)
+{
+    for (uint8_t i = digits; i > 0; i--)
+    {
+        out[i - 1] = '0' + (value % 10);
+        value /= 10;
+    }
+    return out + digits;
+}
+
+/**
+ * @brief Write a Unix time as "YYYY-MM-DD hh:mm:ss" (GMT)
+ * @details Days are turned into a date with the proleptic Gregorian calendar,
+ *          counting years from March so leap days fall at the end of a year
+ * 
+ * @param unixTime The Unix time (GMT)
+ * @param out Where to write the text, at least TIMESTAMP_SIZE bytes
+ * @return The number of characters written, not counting the terminating zero
+ */
+size_t formatTimestamp(uint32_t unixTime, char* out)
+{
+    uint32_t days = unixTime / 86400;
+    uint32_t seconds = unixTime % 86400;
+
+    // Days since 0000-03-01, split into 400 year eras of 146097 days
+    uint32_t z = days + 719468;
+    uint32_t era = z / 146097;
+    uint32_t dayOfEra = z - era * 146097;
+    uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    uint32_t monthIndex = (5 * dayOfYear + 2) / 153;
+    uint32_t day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    uint32_t month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    uint32_t year = yearOfEra + era * 400 + (month <= 2);
+
+    char* p = out;
+    p = putDigits(p, year, 4);
+    *p++ = '-';
+    p = putDigits(p, month, 2);
+    *p++ = '-';
+    p = putDigits(p, day, 2);
+    *p++ = ' ';
+    p = putDigits(p, seconds / 3600, 2);
+    *p++ = ':';
+    p = putDigits(p, (seconds / 60) % 60, 2);
+    *p++ = ':';
+    p = putDigits(p, seconds % 60, 2);
+    *p = '\0';
+
+    return p - out;
+}
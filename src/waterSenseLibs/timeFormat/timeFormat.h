@@ -0,0 +1,43 @@
+/**
+ * @file timeFormat.h
+ * @brief Readable timestamps written without allocating memory
+ * @version 0.1
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#ifndef TIME_FORMAT_H
+#define TIME_FORMAT_H
+
+#include <Arduino.h>
+#include "waterSenseLibs/shares/fixedstring.h"
+
+#define TIMESTAMP_SIZE 20 ///< Room for "YYYY-MM-DD hh:mm:ss" and the terminating zero
+
+typedef FixedString<TIMESTAMP_SIZE> Timestamp; ///< A formatted time, as published through displayTime
+
+/**
+ * @brief Write a Unix time as "YYYY-MM-DD hh:mm:ss" (GMT)
+ * @details Writes the digits directly, without printf() or the C library's
+ *          time functions, so it is safe to call from any task
+ * 
+ * @param unixTime The Unix time (GMT)
+ * @param out Where to write the text, at least TIMESTAMP_SIZE bytes
+ * @return The number of characters written, not counting the terminating zero
+ */
+size_t formatTimestamp(uint32_t unixTime, char* out);
+
+/**
+ * @brief Write a Unix time as "YYYY-MM-DD hh:mm:ss" (GMT) into a Timestamp
+ * 
+ * @param unixTime The Unix time (GMT)
+ * @param out The string to fill in
+ */
+inline void formatTimestamp(uint32_t unixTime, Timestamp& out)
+{
+    formatTimestamp(unixTime, out.text);
+}
+
+#endif //TIME_FORMAT_H
@@ -0,0 +1,28 @@
+/**
+ * @file gnssFix.h
+ * @brief The position fix the clock task publishes for the other tasks
+ * @version 0.1
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#ifndef GNSS_FIX_H
+#define GNSS_FIX_H
+
+#include <Arduino.h>
+
+/**
+ * @brief One position fix, published as a whole through gnssFix
+ * 
+ */
+struct GNSSFix
+{
+    int32_t latitude; ///< Latitude in 1e-7 degrees
+    int32_t longitude; ///< Longitude in 1e-7 degrees
+    int32_t altitude; ///< Altitude in meters above MSL
+    bool valid; ///< The location, time and date were all valid when the fix was taken
+};
+
+#endif //GNSS_FIX_H
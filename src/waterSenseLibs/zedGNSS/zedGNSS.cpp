@@ -54,21 +54,17 @@ void GNSS :: start() {
     setDisplayTime();
     Serial.println("Set display time");
 
-    Serial.println("Getting altitude...");
-    altitude.put(gnss.getAltitude());
-    Serial.println("Got altitude");
-
-    Serial.println("Getting latitude...");
-    latitude.put(gnss.getLatitude());
-    Serial.println("Got latitude");
-
-    Serial.println("Getting longitude...");
-    longitude.put(gnss.getLongitude());
-    Serial.println("Got longitude");
-
-    wakeReady.put(locFix&&timeValid&&dateValid);
-    fixType.put(locFix&&timeValid&&dateValid);
-    Serial.printf("GNSS successfully initialized. location valid: %hhu, time valid: %d, date valid: %d, Wake everyone?: %d\n", locFix, timeValid, dateValid, wakeReady.get());
+    Serial.println("Getting position...");
+    GNSSFix fix;
+    fix.altitude = gnss.getAltitudeMSL() / (int32_t) 1000;
+    fix.latitude = gnss.getLatitude();
+    fix.longitude = gnss.getLongitude();
+    fix.valid = locFix&&timeValid&&dateValid;
+    gnssFix.put(fix); // Published together so no task sees half of an old fix
+    Serial.println("Got position");
+
+    taskFlags.put(FLAG_WAKE_READY, fix.valid);
+    Serial.printf("GNSS successfully initialized. location valid: %hhu, time valid: %d, date valid: %d, Wake everyone?: %d\n", locFix, timeValid, dateValid, fix.valid);
 }
 
 // void GNSS :: start_no_survey() {
@@ -95,16 +91,28 @@ void GNSS :: getGNSSData() {
         if(gnss.checkUblox() == false) {
           return;
         }
-        if(gnss.fileBufferAvailable() >= (sdWriteSize)) {
-              gnss.extractFileBufferData(myBuffer, sdWriteSize); // Extract exactly sdWriteSize bytes from the UBX file buffer and put them into myBuffer
-              gnssDataReady.put(true);
-              // for(int i = 0; i < sdWriteSize; i++) {
-              //   writeBuffer.put(myBuffer[i]);
-              //   unixTime.put(gnss.getUnixEpoch());
-              // }
+        // Hand over as many full blocks as there are free buffers
+        while(gnss.fileBufferAvailable() >= (sdWriteSize)) {
+              uint8_t slot;
+              uint8_t *buffer = gnssBuffers.acquire(slot);
+              if(buffer == NULL) {
+                // SD task still owns every buffer, leave the data in the u-blox file buffer
+                return;
+              }
+              gnss.extractFileBufferData(buffer, sdWriteSize); // Extract exactly sdWriteSize bytes from the UBX file buffer into the free buffer
+
+              // Hand the buffer to the SD task, it releases it once written
+              SDRequest request;
+              request.type = SD_GNSS_BLOCK;
+              request.gnss.slot = slot;
+              request.gnss.length = sdWriteSize;
+              if(!sdRequests.put(request)) {
+                Serial.println("SD queue full, GNSS block dropped");
+                gnssBuffers.drop(slot);
+                return;
+              }
               Serial.println("GNSS Buffer populated in queue");
               gnss.checkUblox(); // Check for the arrival of new data and process it. 
-              return;
         }
         return;
 }
@@ -112,8 +120,9 @@ void GNSS :: getGNSSData() {
 
 
 void GNSS :: setDisplayTime() {
-  String s = String(unixTime.get());
-  displayTime.put(s);
+  Timestamp text;
+  formatTimestamp(unixTime.get(), text);
+  displayTime.put(text);
 }
 
 void newSFRBX(UBX_RXM_SFRBX_data_t *ubxDataStruct) 
@@ -19,11 +19,37 @@
 // Declare external global instance
 extern BluetoothFileManager bluetoothFileManager;
 
+/**
+ * @brief Hand a BLE event to the Bluetooth task
+ * @details ArduinoBLE runs its event handlers from inside BLE.poll(), in the
+ *          Bluetooth task itself, so this must never wait for room
+ * 
+ * @param event A BLEEventType
+ */
+static void postBLEEvent(uint8_t event)
+{
+  if (xQueueSendToBack(bleEvents.get_handle(), &event, 0) != pdTRUE) {
+    Serial.printf("BLE event %u dropped\n", event);
+  }
+}
+
+static void onConnected(BLEDevice central) { postBLEEvent(BLE_EVENT_CONNECTED); }
+static void onDisconnected(BLEDevice central) { postBLEEvent(BLE_EVENT_DISCONNECTED); }
+static void onRequestWritten(BLEDevice central, BLECharacteristic characteristic) { postBLEEvent(BLE_EVENT_REQUEST); }
+static void onChecksumWritten(BLEDevice central, BLECharacteristic characteristic) { postBLEEvent(BLE_EVENT_CHECKSUM); }
+
 /**
  * @brief The Bluetooth task
- * @details Advertises for 100ms every 10 seconds (9.9s off, 0.1s on)
+ * @details Advertises continuously every BLE_ADVERT_INTERVAL while awake. The
+ *          connect, disconnect and written handlers post to bleEvents, which
+ *          drives the state machine. The handlers only run when the task
+ *          polls, so it polls on a fixed period: BLE_IDLE_PERIOD while
+ *          advertising and BLE_CONNECTED_PERIOD while connected. Events wait
+ *          up to one period for the task. Only a transfer polls without
+ *          sleeping.
  * 
- * Write filelist.txt to SD card, be careful with race conditions
+ * Directories are listed with "LIST <dir> [cursor]", one page of entries at
+ * a time, without writing anything to the SD card
  * 
  * @param params A pointer to task parameters
  */
@@ -32,31 +58,66 @@ void taskBluetooth(void* params)
 
   // BLE Service and Characteristics (global scope)
   BLEService dataService("12345678-1234-5678-1234-56789abcdef0");
-  BLEStringCharacteristic fileRequestChar("12345678-1234-5678-1234-56789abcdef2", BLEWrite, 50);
-  BLECharacteristic fileChunkChar("12345678-1234-5678-1234-56789abcdef3", BLENotify, 110);
+  BLEStringCharacteristic fileRequestChar("12345678-1234-5678-1234-56789abcdef2", BLEWrite, 100);
+  BLECharacteristic fileChunkChar("12345678-1234-5678-1234-56789abcdef3", BLENotify, BT_MAX_CHUNK_SIZE);
   BLEStringCharacteristic checksumChar("12345678-1234-5678-1234-56789abcdef4", BLERead | BLEWrite, 50);
   BLEStringCharacteristic statusChar("12345678-1234-5678-1234-56789abcdef5", BLENotify, 50);
   BLEStringCharacteristic bPercentchar("12345678-1234-5678-1234-56789abcdef6", BLENotify, 50);//battery percentage
+  BLECharacteristic blockCrcChar("12345678-1234-5678-1234-56789abcdef7", BLENotify, sizeof(BlockCrc));//CRC32 of each block of a GET transfer
+  BLECharacteristic dirListChar("12345678-1234-5678-1234-56789abcdef8", BLENotify, BT_MAX_CHUNK_SIZE);//DirEntry records of a LIST page
   // File transfer variables
   String requestedFile = "";
   int offset = 0;
   uint32_t calculatedChecksum = 0;
   uint32_t receivedChecksum = 0;
   bool transferComplete = false;
+  uint32_t connectedSince = 0;
+  uint16_t chunkSize = BT_CHUNK_SIZE; ///< Bytes per notification, set from the MTU the client reports
+  uint32_t transferStart = 0;
+  uint32_t lastSent = 0; ///< millis() when the client last took a chunk of the transfer
+  uint8_t chunk[BT_MAX_CHUNK_SIZE]; ///< The chunk being sent
+  size_t chunkLength = 0; ///< Bytes in chunk that still have to be sent
+  size_t chunkHeader = 0; ///< Bytes at the start of chunk that are its offset, not file data
+  bool framed = false; ///< Chunks start with their file offset, for GET requests
+  const char* recordQuery = NULL; ///< Status prefix of the last sample sent when the transfer is samples, not a file
+  String retryFile = ""; ///< File the retry count is for
+  uint8_t retries = 0; ///< Failed checksums of retryFile in a row
+  bool requestPending = false; ///< The request characteristic was written and not handled yet
+  bool checksumPending = false; ///< The checksum characteristic was written and not handled yet
+  uint8_t event = BLE_EVENT_NONE; ///< The BLE event being handled
   // Task Setup
   uint8_t state = 0;
   UBaseType_t originalPriority = uxTaskPriorityGet(NULL);
 
   // Wait for Serial to be ready
   vTaskDelay(pdMS_TO_TICKS(2000));
-  Serial.println("Bluetooth task started, awaiting wakeready");
+  Serial.println("Bluetooth task started, awaiting wake");
 
   // Task Loop
   while (true)
   {
+      // ArduinoBLE runs the handlers above from BLE.poll(), in this task, so
+      // nothing can post an event while it sleeps. A poll with a timeout spins
+      // on the ESP32 instead of blocking, so sleep for the poll period, poll
+      // without one and take the events it posted. How long a connection or
+      // request waits for the task is bounded by the poll period
+      event = BLE_EVENT_NONE;
+      if (state != 0) {
+        if (bleEvents.is_empty()) {
+          TickType_t wait = 0;
+          if (state == 1) wait = pdMS_TO_TICKS(BLE_IDLE_PERIOD);
+          else if (state == 2 || state == 4) wait = pdMS_TO_TICKS(BLE_CONNECTED_PERIOD);
+
+          if (wait) vTaskDelay(wait);
+          BLE.poll();
+        }
+        xQueueReceive(bleEvents.get_handle(), &event, 0);
+      }
+      if (event == BLE_EVENT_REQUEST) requestPending = true;
+      else if (event == BLE_EVENT_CHECKSUM) checksumPending = true;
+
       if(state == 0) {
-        if(wakeReady.get()) {
-          writeFinishedSD.put(true);
+        if(taskFlags.wait_all(FLAG_WAKE_READY, pdMS_TO_TICKS(WATCH_CHECK_PERIOD))) {
           // Reset file transfer state variables
           offset = 0;
           requestedFile = "";
@@ -78,11 +139,23 @@ void taskBluetooth(void* params)
           dataService.addCharacteristic(fileChunkChar);
           dataService.addCharacteristic(checksumChar);
           dataService.addCharacteristic(statusChar);
+          dataService.addCharacteristic(blockCrcChar);
+          dataService.addCharacteristic(dirListChar);
 
           BLE.addService(dataService);
           
-          // Signal that Bluetooth is always ready to sleep
-          bluetoothSleepReady.put(true);
+          // Everything the task waits for arrives through bleEvents
+          BLE.setEventHandler(BLEConnected, onConnected);
+          BLE.setEventHandler(BLEDisconnected, onDisconnected);
+          fileRequestChar.setEventHandler(BLEWritten, onRequestWritten);
+          checksumChar.setEventHandler(BLEWritten, onChecksumWritten);
+          
+          // Advertise for as long as the device is awake, the interval sets the power it costs
+          BLE.setAdvertisingInterval(BLE_ADVERT_INTERVAL);
+          BLE.advertise();
+          
+          // Signal that Bluetooth is ready to sleep until a central connects
+          taskFlags.set(FLAG_BLUETOOTH_SLEEP_READY);
 
           Serial.println("Bluetooth task initialized with SD card file transfer interface");
 
@@ -91,79 +164,186 @@ void taskBluetooth(void* params)
       }
 
       else if(state == 1) {//ADVERTISE
-        //resume normal SD operations
-        BluetoothConnected.put(false);
-
-        //tell watchdog I am alive
-        bluetoothCheck.put(true);
-        if(sleepFlag.get()){
-          state = 6;
+        if(taskFlags.is_set(FLAG_BLUETOOTH_CONNECTED)){
+          taskFlags.clear(FLAG_BLUETOOTH_CONNECTED);
+          logEvent(EVENT_BLE_DISCONNECT, SOURCE_BLUETOOTH, millis() - connectedSince);
+          BLE.advertise(); // The controller stops advertising for the connection
+          taskFlags.set(FLAG_BLUETOOTH_SLEEP_READY);
         }
-        
-        vTaskDelay(pdMS_TO_TICKS(BLE_ADVERT_PERIOD));//change this to set how long the gap between advertising is
 
-        // Start advertising
-        BLE.advertise();
-        Serial.println("Bluetooth advertising started");
-        // Check for connection during advertising
         BLEDevice central = BLE.central();
-        if (central) {
+        if(taskFlags.is_set(FLAG_SLEEP)){
+          BLE.stopAdvertise();
+          Serial.println("Bluetooth advertising stopped");
+          state = 6;
+        }
+        else if (central) {
           Serial.print("Connected to: ");
           Serial.println(central.address());
           state = 2;
           vTaskPrioritySet(NULL, 20); // Increase priority when connected
-          bluetoothSleepReady.put(false); // Prevent sleep while connected
-          BluetoothConnected.put(true);//stop SD operation after writes finished
-          while(writeFinishedSD.get()!=true){
-            vTaskDelay(pdMS_TO_TICKS(20));
-            bluetoothCheck.put(true);
-          }
-          vTaskDelay(pdMS_TO_TICKS(100));//delay a bit to let SD task wrap up. 
+          taskFlags.clear(FLAG_BLUETOOTH_SLEEP_READY); // Prevent sleep while connected
+          connectedSince = millis();
+          chunkSize = BT_CHUNK_SIZE;
+          requestPending = false;
+          checksumPending = false;
+          bluetoothFileManager.setCodec(CODEC_NONE);
+          logEvent(EVENT_BLE_CONNECT, SOURCE_BLUETOOTH);
+          taskFlags.set(FLAG_BLUETOOTH_CONNECTED);//sampling and logging carry on, the card is shared through sdBus
+          
+          char bufferp[20];
+          sprintf(bufferp, "%.2f", batteryPercent.get());
+          bPercentchar.writeValue(bufferp);//send battery percent level
         }
-
-        // Stop advertising after 100ms
-        vTaskDelay(pdMS_TO_TICKS(200));
-        BLE.stopAdvertise();
-        Serial.println("Bluetooth advertising stopped");
-        bluetoothSleepReady.put(true);
       }
 
       else if(state == 2) {//CONNECTED
-        if (BLE.connected()) {
-          char bufferp[20];
-          sprintf(bufferp, "%.2f", batteryPercent.get());  
-          bPercentchar.writeValue(bufferp);//send battery percent level
+        if (BLE.connected() && event != BLE_EVENT_DISCONNECTED) {
           // Check for file request
-          if (fileRequestChar.written()) {
+          if (requestPending) {
+            requestPending = false;
             requestedFile = fileRequestChar.value();
             offset = 0;
             transferComplete = false;
             
-            // Check if client is requesting file list
-            if (requestedFile == "filelist.txt") {
-              Serial.println("File list requested - generating filelist.txt");
+            // Client reporting the ATT MTU it negotiated, e.g. "MTU 247"
+            if (requestedFile.startsWith("MTU ")) {
+              long mtu = requestedFile.substring(4).toInt();
+              chunkSize = (mtu > 3 + BT_FRAME_HEADER_SIZE) ? mtu - 3 : BT_CHUNK_SIZE;
+              if (chunkSize > BT_MAX_CHUNK_SIZE) chunkSize = BT_MAX_CHUNK_SIZE;
+              Serial.printf("Client MTU %ld, sending %u byte chunks\n", mtu, chunkSize);
+              statusChar.writeValue(String("CHUNK_SIZE ") + chunkSize);
+            }
+            // Client choosing how samples are encoded, "COMPRESS DELTA" or "COMPRESS NONE".
+            // The reply is the codec that will be used, unknown ones leave it as it was
+            else if (requestedFile.startsWith("COMPRESS ")) {
+              String name = requestedFile.substring(9);
+              if (name == "DELTA") bluetoothFileManager.setCodec(CODEC_DELTA);
+              else if (name == "NONE") bluetoothFileManager.setCodec(CODEC_NONE);
+              statusChar.writeValue(bluetoothFileManager.getCodec() == CODEC_DELTA ? "COMPRESSION DELTA" : "COMPRESSION NONE");
+            }
+            // Client asking for samples instead of files, every one after the newest
+            // one it has, "SINCE <unix time>", or a window, "QUERY <t0> <t1> [decimate]"
+            else if (requestedFile.startsWith("SINCE ") || requestedFile.startsWith("QUERY ")) {
+              bool since = requestedFile.startsWith("SINCE ");
+              unsigned long t0 = 0;
+              unsigned long t1 = 0;
+              unsigned int decimate = 1;
+              int fields = since ? sscanf(requestedFile.c_str(), "SINCE %lu", &t0)
+                                 : sscanf(requestedFile.c_str(), "QUERY %lu %lu %u", &t0, &t1, &decimate);
+              if (retryFile != requestedFile) {
+                retryFile = requestedFile;
+                retries = 0;
+              }
               
-              // Generate the file list
-              if (bluetoothFileManager.generateFileList()) {
-                statusChar.writeValue(String("FILELISTS_MADE ")+FILELIST_COUNT.get());
+              // The file the SD task is appending to is not read. Have it start a
+              // new one, but only when the range reaches into it
+              uint32_t first = (since && t0 < UINT32_MAX) ? t0 + 1 : t0;
+              uint32_t last = since ? UINT32_MAX : t1;
+              if (bluetoothFileManager.reachesOpenFile(first, last)) {
+                taskFlags.clear(FLAG_SD_ROLLOVER_DONE);
+                SDRequest rollover;
+                rollover.type = SD_ROLLOVER;
+                if (sdRequests.put(rollover)) {
+                  taskFlags.wait_all(FLAG_SD_ROLLOVER_DONE, pdMS_TO_TICKS(SD_QUEUE_WAIT), true);
+                }
+              }
+              
+              bool loaded = false;
+              if (since && fields == 1) loaded = bluetoothFileManager.loadSince(t0);
+              else if (!since && fields >= 2) loaded = bluetoothFileManager.loadRange(t0, t1, decimate);
+              if (loaded) {
+                framed = false;
+                recordQuery = since ? "SINCE_LAST " : "QUERY_LAST ";
+                calculatedChecksum = 0;
+                transferStart = millis();
+                lastSent = transferStart;
+                chunkLength = 0;
+                state = 3;
+                taskFlags.clear(FLAG_BLUETOOTH_SLEEP_READY);
+              } else {
+                statusChar.writeValue(since ? "SINCE_FAILED" : "QUERY_FAILED");
+                state = 5;
+              }
+            }
+            // Client listing a directory a page at a time, "LIST <dir> [cursor]"
+            else if (requestedFile.startsWith("LIST ")) {
+              char path[64];
+              unsigned long cursor = 0;
+              if (sscanf(requestedFile.c_str(), "LIST %63s %lu", path, &cursor) >= 1
+                  && bluetoothFileManager.openDirectory(path, cursor, BT_LIST_PAGE_SIZE)) {
+                // Entries are packed into as few notifications as they fit in
+                size_t length;
+                bool stalled = false;
+                while (!stalled && BLE.connected() && (length = bluetoothFileManager.readDirectory(chunk, chunkSize)) > 0) {
+                  // Given up on like a transfer if the client stops taking them
+                  uint32_t waitStart = millis();
+                  while (BLE.connected() && !dirListChar.writeValue(chunk, length)) {
+                    if (millis() - waitStart >= BT_STALL_TIMEOUT) {
+                      stalled = true;
+                      break;
+                    }
+                    watchChecks.set(CHECK_BLUETOOTH);
+                    BLE.poll();
+                    vTaskDelay(1);
+                  }
+                  watchChecks.set(CHECK_BLUETOOTH);
+                }
+                
+                if (stalled) {
+                  Serial.println("Directory listing stalled, giving up");
+                  statusChar.writeValue("LIST_STALLED");
+                } else if (bluetoothFileManager.isDirectoryEnd()) {
+                  statusChar.writeValue("LIST_END");
+                } else {
+                  statusChar.writeValue(String("LIST_NEXT ") + bluetoothFileManager.getDirectoryCursor());
+                }
+                bluetoothFileManager.closeDirectory();
               } else {
-                Serial.println("Failed to generate filelist.txt");
-                statusChar.writeValue("FILELISTS_FAILED");
+                Serial.print("Failed to list directory: ");
+                Serial.println(requestedFile);
+                bluetoothFileManager.closeDirectory();
+                statusChar.writeValue("LIST_FAILED");
                 state = 5;
               }
             } else {
-              // Load the requested file
-              if (bluetoothFileManager.loadFile(requestedFile)) {
-                calculatedChecksum = bluetoothFileManager.getCurrentChecksum();
+              // Either "GET <path> [offset] [length]", sent back in chunks that
+              // start with their offset in the file, or just a path for the whole file
+              char path[64];
+              unsigned long rangeOffset = 0;
+              unsigned long rangeLength = 0;
+              framed = requestedFile.startsWith("GET ");
+              recordQuery = NULL;
+              if (framed) {
+                if (sscanf(requestedFile.c_str(), "GET %63s %lu %lu", path, &rangeOffset, &rangeLength) < 1) path[0] = '\0';
+              } else {
+                snprintf(path, sizeof(path), "%s", requestedFile.c_str());
+              }
+              
+              // Retries are counted per file so a bad link gives up in the end
+              if (retryFile != path) {
+                retryFile = path;
+                retries = 0;
+              }
+              
+              // Load the requested file, unless the SD task is still writing it
+              if (path[0] != '\0' && bluetoothFileManager.isFileBusy(path)) {
+                Serial.print("File is being written: ");
+                Serial.println(path);
+                statusChar.writeValue("FILE_BUSY");
+              }
+              else if (path[0] != '\0' && bluetoothFileManager.loadFile(path, rangeOffset, rangeLength)) {
+                calculatedChecksum = 0;
                 Serial.print("File requested: ");
                 Serial.println(requestedFile);
-                Serial.print("File loaded: ");
-                Serial.print(bluetoothFileManager.getFileData().length());
+                Serial.print("File size: ");
+                Serial.print(bluetoothFileManager.getFileSize());
                 Serial.println(" bytes");
-                Serial.print("Calculated checksum: ");
-                Serial.println(calculatedChecksum);
+                transferStart = millis();
+                lastSent = transferStart;
+                chunkLength = 0;
                 state = 3;
-                bluetoothSleepReady.put(false);
+                taskFlags.clear(FLAG_BLUETOOTH_SLEEP_READY);
               } else {
                 Serial.print("Failed to load file: ");
                 statusChar.writeValue("FILE_LOAD_FAILED");
@@ -181,20 +361,75 @@ void taskBluetooth(void* params)
       }
 
       else if(state == 3) {//TRANSFER
-        if (BLE.connected()) {
-          String fileData = bluetoothFileManager.getFileData();
+        if (BLE.connected() && event != BLE_EVENT_DISCONNECTED) {
+          // Send the next chunks straight from the card. writeValue() waits for
+          // the controller to have a free buffer, which paces the notifications
+          bool finished = false;
+          for (uint8_t i = 0; i < BT_CHUNKS_PER_LOOP; i++) {
+            if (chunkLength == 0) {
+              // A framed chunk starts with the little endian file offset of its data
+              uint32_t chunkOffset = bluetoothFileManager.getPosition();
+              chunkHeader = framed ? BT_FRAME_HEADER_SIZE : 0;
+              size_t length = bluetoothFileManager.readChunk(chunk + chunkHeader, chunkSize - chunkHeader);
+              if (length == 0) {
+                finished = true;
+                break;
+              }
+              memcpy(chunk, &chunkOffset, chunkHeader);
+              chunkLength = chunkHeader + length;
+            }
+            
+            // The CRC of every block goes out before its data, so a bad block can be requested again alone.
+            // A CRC is only dropped once it is sent, until then it and the chunk wait for the next pass
+            BlockCrc blockCrc;
+            bool crcSent = true;
+            while (crcSent && bluetoothFileManager.peekBlockCrc(blockCrc)) {
+              crcSent = !framed || blockCrcChar.writeValue((uint8_t*) &blockCrc, sizeof(blockCrc));
+              if (crcSent) {
+                bluetoothFileManager.popBlockCrc();
+                lastSent = millis();
+              }
+            }
+            if (!crcSent) break;
+            
+            if (!fileChunkChar.writeValue(chunk, chunkLength)) break; // Sent again next pass
+            offset += chunkLength - chunkHeader;
+            chunkLength = 0;
+            lastSent = millis();
+          }
           
-          if (offset < fileData.length()) {
-            // Send next chunk
-            int chunkSize = (fileData.length() - offset < 100) ? (fileData.length() - offset) : 100;
-            String chunk = fileData.substring(offset, offset + chunkSize);
-            fileChunkChar.writeValue(chunk.c_str());
-            offset += chunkSize;
-            vTaskDelay(pdMS_TO_TICKS(100)); // Throttle notifications
-            bluetoothSleepReady.put(false);
+          if (!finished && millis() - lastSent >= BT_STALL_TIMEOUT) {
+            // The client stopped taking notifications, or never subscribed to them
+            Serial.println("Transfer stalled, giving up");
+            bluetoothFileManager.clearFile();
+            statusChar.writeValue("TRANSFER_STALLED");
+            offset = 0;
+            requestedFile = "";
+            calculatedChecksum = 0;
+            transferComplete = false;
+            state = 2;
+          }
+          else if (!finished) {
+            watchChecks.set(CHECK_BLUETOOTH);
+            taskFlags.clear(FLAG_BLUETOOTH_SLEEP_READY);
+            vTaskDelay(1); // Let other tasks run between bursts
           } else {
             // Transfer complete, send checksum for verification
+            calculatedChecksum = bluetoothFileManager.getCurrentChecksum();
+            if (recordQuery) {
+              // The newest sample sent is the client's watermark for next time
+              statusChar.writeValue(String(recordQuery) + bluetoothFileManager.getLastRecordTime() + " " + bluetoothFileManager.getRecordCount());
+            }
+            bluetoothFileManager.clearFile();
+            Serial.print("Calculated checksum: ");
+            Serial.println(calculatedChecksum);
             Serial.println("Transfer complete. Waiting for checksum verification...");
+            
+            // Report achieved throughput as bytes, ms and bytes per second
+            uint32_t elapsed = millis() - transferStart;
+            uint32_t rate = elapsed ? (uint64_t) offset * 1000 / elapsed : offset;
+            Serial.printf("Sent %d bytes in %u ms (%u B/s)\n", offset, elapsed, rate);
+            statusChar.writeValue(String("THROUGHPUT ") + offset + " " + elapsed + " " + rate);
             statusChar.writeValue("TRANSFER_COMPLETE");
             checksumChar.writeValue(String(calculatedChecksum));
             state = 4;
@@ -219,9 +454,10 @@ void taskBluetooth(void* params)
       }
 
       else if(state == 4) {//VERIFY
-        if (BLE.connected()) {
+        if (BLE.connected() && event != BLE_EVENT_DISCONNECTED) {
           // Check if client sent back checksum
-          if (checksumChar.written()) {
+          if (checksumPending) {
+            checksumPending = false;
             String checksumStr = checksumChar.value();
             
             // Convert string to uint32_t safely
@@ -237,9 +473,19 @@ void taskBluetooth(void* params)
                 Serial.println("Checksum verified! Transfer successful.");
                 statusChar.writeValue("TRANSFER_SUCCESS");
                 transferComplete = true;
+                retries = 0;
+                state = 2;
+              } else if (++retries >= BT_MAX_RETRIES) {
+                Serial.println("Checksum mismatch! Giving up on this file");
+                statusChar.writeValue("TRANSFER_FAILED");
+                retries = 0;
+                offset = 0;
+                requestedFile = "";
+                calculatedChecksum = 0;
+                transferComplete = false;
                 state = 2;
               } else {
-                Serial.println("Checksum mismatch! Restarting transfer...");
+                Serial.println("Checksum mismatch! Waiting for the client to request it again...");
                 statusChar.writeValue("RETRY_TRANSFER");
                 // Reset for retry
                 offset = 0;
@@ -250,7 +496,8 @@ void taskBluetooth(void* params)
               }
             } else {
               Serial.println("Invalid checksum format received");
-              statusChar.writeValue("RETRY_TRANSFER");
+              statusChar.writeValue((++retries >= BT_MAX_RETRIES) ? "TRANSFER_FAILED" : "RETRY_TRANSFER");
+              if (retries >= BT_MAX_RETRIES) retries = 0;
               // Reset for retry
               offset = 0;
               requestedFile = "";
@@ -295,20 +542,16 @@ void taskBluetooth(void* params)
         statusChar.writeValue("Error: File transfer failed");
         vTaskDelay(pdMS_TO_TICKS(1000)); // Wait a bit before returning to connected state
         state = 2;
-        bluetoothSleepReady.put(false);
+        taskFlags.clear(FLAG_BLUETOOTH_SLEEP_READY);
       }
 
       else if(state == 6) {//SLEEP
         Serial.println("Bluetooth task sleeping");
-        bluetoothSleepReady.put(true);
+        taskFlags.set(FLAG_BLUETOOTH_SLEEP_READY);
         vTaskDelay(pdMS_TO_TICKS(1000));
       }
     
     
-    // Handle BLE events more frequently for better responsiveness
-    BLE.poll();
-    
-    vTaskDelay(pdMS_TO_TICKS(BLE_POLLING_FREQ));
-    bluetoothCheck.put(true);
+    watchChecks.set(CHECK_BLUETOOTH);
   }
 }
\ No newline at end of file
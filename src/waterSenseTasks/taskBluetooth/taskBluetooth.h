@@ -11,4 +11,17 @@
 
 #include <ArduinoBLE.h>
 
+/**
+ * @brief What the ArduinoBLE event handlers tell the Bluetooth task
+ * 
+ */
+enum BLEEventType : uint8_t
+{
+    BLE_EVENT_NONE, ///< Nothing happened, BLE.poll() timed out
+    BLE_EVENT_CONNECTED, ///< A central connected
+    BLE_EVENT_DISCONNECTED, ///< The central disconnected
+    BLE_EVENT_REQUEST, ///< The central wrote the file request characteristic
+    BLE_EVENT_CHECKSUM ///< The central wrote the checksum characteristic
+};
+
 void taskBluetooth(void* params);
\ No newline at end of file
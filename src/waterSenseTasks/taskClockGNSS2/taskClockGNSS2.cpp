@@ -32,8 +32,8 @@ void taskClockGNSS2(void* params)
   {
     //radarSleepReady.put(true);radarCheck.put(true);//for testing WITHOUT radar
     #ifndef BLE_on
-      bluetoothSleepReady.put(true);
-      bluetoothCheck.put(true);//for testing without bluetooth
+      taskFlags.set(FLAG_BLUETOOTH_SLEEP_READY);
+      watchChecks.set(CHECK_BLUETOOTH);//for testing without bluetooth
     #endif
     // Begin
     if (state == 0)
@@ -54,7 +54,7 @@ void taskClockGNSS2(void* params)
       float localHour = fmod((localSolarTime % 86400L) / 3600.0, 24.0);
       Serial.println("GNSSv2 calculated local hour");
 
-      if (!BluetoothConnected.get() && gnssOn && (wakeCounter == 0 || ((ada_rtc.now().unixtime()-lastFixedUTX) >= 2592000UL && ((localHour >= 6.0 && localHour <= 10.0)))))//check to see if 1 month passed AND GNSS is enabled and its day and BLE disconnected
+      if (!taskFlags.is_set(FLAG_BLUETOOTH_CONNECTED) && gnssOn && (wakeCounter == 0 || ((ada_rtc.now().unixtime()-lastFixedUTX) >= 2592000UL && ((localHour >= 6.0 && localHour <= 10.0)))))//check to see if 1 month passed AND GNSS is enabled and its day and BLE disconnected
       {
         Serial.println("Initiating Monthly long hour survey");
         myGNSS.start(); 
@@ -67,7 +67,7 @@ void taskClockGNSS2(void* params)
         Serial.println("Getting Timestamp from internal RTC");
         inLongSurvey.put(0);
         vTaskDelay(CLOCK_PERIOD);
-        wakeReady.put(true);
+        taskFlags.set(FLAG_WAKE_READY);
 
         state = 1;
       }
@@ -75,19 +75,19 @@ void taskClockGNSS2(void* params)
     else if (state == 1)
     {
       unixTime.put(ada_rtc.now().unixtime());
-      displayTime.put(String(ada_rtc.now().unixtime()));
-      clockSleepReady.put(true);
+      myGNSS.setDisplayTime();
+      taskFlags.set(FLAG_CLOCK_SLEEP_READY);
       sleepTime.put((uint64_t) (READ_TIME.get() * 1000000));
     }
     // Update
-    else if (state == 2 && !BluetoothConnected.get())
+    else if (state == 2)
     {
       vTaskDelay(5000);
-      while(fixType.get() != 1) {
+      while(!gnssFix.get().valid) {
           //myGNSS.gnss.factoryReset(); // Cold start - clears position data
           Serial.println("Cold Starting... ");
           myGNSS.start();
-          clockCheck.put(true);
+          watchChecks.set(CHECK_CLOCK);
           vTaskDelay(5000);
       }
       unixTime.put(myGNSS.gnss.getUnixEpoch());
@@ -98,12 +98,14 @@ void taskClockGNSS2(void* params)
       vTaskDelay(500);
       // wakeReady.put(true);//have wakeready be set by zedgnss.cpp
       // If sleepFlag is tripped, go to state 3
-      if (sleepFlag.get())
+      if (taskFlags.is_set(FLAG_SLEEP))
       {
-        Serial.println("GNSSv2 1 -> 3, sleepFlag ready");
-        latitude.put(myGNSS.gnss.getHighResLatitude());
-        longitude.put(myGNSS.gnss.getHighResLongitude());
-        altitude.put(myGNSS.gnss.getAltitudeMSL() / (int32_t) 1000);
+        Serial.println("GNSSv2 1 -> 3, sleep flag set");
+        GNSSFix fix = gnssFix.get();
+        fix.latitude = myGNSS.gnss.getHighResLatitude();
+        fix.longitude = myGNSS.gnss.getHighResLongitude();
+        fix.altitude = myGNSS.gnss.getAltitudeMSL() / (int32_t) 1000;
+        gnssFix.put(fix);
         state = 3;
       }
       myGNSS.getGNSSData();//GET CURRENT GNSSDATA
@@ -120,15 +122,40 @@ void taskClockGNSS2(void* params)
       if (maxBufferBytes > ((fileBufferSize / 5) * 4)){// Warn the user if fileBufferSize was more than 80% full 
             Serial.println(F("Warning: the file buffer has been over 80% full. Some data may have been lost."));
       } 
+      gnssBuffers.printStats(Serial);
+      GNSSFix fix = gnssFix.get();
+      if (fix.valid){ // Log the fix along with the survey
+        logEvent(EVENT_FIX, SOURCE_CLOCK, fix.latitude, fix.longitude, fix.altitude);
+      }
+      myGNSS.gnss.checkUblox(); // Pull in anything still waiting on the module
       uint16_t remainingBytes = myGNSS.gnss.fileBufferAvailable(); // Check if there are any bytes remaining in the file buffer 
       while (remainingBytes > 0){ // While there is still data in the file buffer 
           uint16_t bytesToWrite = remainingBytes; // Write the remaining bytes to SD card sdWriteSize bytes at a time 
           if (bytesToWrite > sdWriteSize){ 
               bytesToWrite = sdWriteSize; 
             }
-          myGNSS.gnss.extractFileBufferData(myBuffer, bytesToWrite); // Extract bytesToWrite bytes from the UBX file buffer and put them into myBuffer 
+          uint8_t slot;
+          uint8_t *buffer = gnssBuffers.acquire(slot);
+          if (buffer == NULL){ // Wait for the SD task to hand a buffer back
+            watchChecks.set(CHECK_CLOCK);
+            vTaskDelay(SD_PERIOD);
+            continue;
+          }
+          myGNSS.gnss.extractFileBufferData(buffer, bytesToWrite); // Extract bytesToWrite bytes from the UBX file buffer into the free buffer 
+          SDRequest blockRequest; // The SD task appends partial blocks as they are
+          blockRequest.type = SD_GNSS_BLOCK;
+          blockRequest.gnss.slot = slot;
+          blockRequest.gnss.length = bytesToWrite;
+          while (!sdRequests.put(blockRequest)){
+            watchChecks.set(CHECK_CLOCK);
+          }
         remainingBytes -= bytesToWrite; // Decrement remainingBytes 
       }
+      SDRequest endRequest; // Nothing more is coming, let the SD task close the file
+      endRequest.type = SD_GNSS_END;
+      while (!sdRequests.put(endRequest)){ // The SD task waits for it before sleeping, it must not be dropped
+        watchChecks.set(CHECK_CLOCK);
+      }
       ///////////////////////////////////////////////////////////////////////////////////////
       unixTime.put(myGNSS.gnss.getUnixEpoch());
       myGNSS.setDisplayTime();
@@ -144,14 +171,19 @@ void taskClockGNSS2(void* params)
 
       vTaskDelay(1000);
 
-      clockSleepReady.put(true);
+      // Only sleep once the SD task has written, synced and closed the UBX file
+      while (!taskFlags.wait_all(FLAG_SD_SLEEP_READY, pdMS_TO_TICKS(WATCH_CHECK_PERIOD))){
+        watchChecks.set(CHECK_CLOCK);
+      }
+
+      taskFlags.set(FLAG_CLOCK_SLEEP_READY);
       state = 4;
     }
     if(state == 4) {
       Serial.println("GNSSv2 4, sleeping ");
       vTaskDelay(2000);
     }
-    clockCheck.put(true);
+    watchChecks.set(CHECK_CLOCK);
     vTaskDelay(CLOCK_PERIOD);
   }
 }
\ No newline at end of file
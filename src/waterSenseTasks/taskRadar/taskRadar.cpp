@@ -24,19 +24,21 @@
      const uint32_t RANGE_MAX = 13000;  // mm
  
      uint8_t state = 0;
-     Serial.println("[RadarTask] Task started, awaiting wakeReady...");
+     uint32_t droppedSamples = 0;  // Samples the SD queue had no room for, not yet logged
+     Serial.println("[RadarTask] Task started, awaiting wake...");
  
      while (true)
      {
          if (state == 0)  // ── Initialization ──
          {
-             if (wakeReady.get())
+             if (taskFlags.wait_all(FLAG_WAKE_READY, pdMS_TO_TICKS(WATCH_CHECK_PERIOD)))
              {
                  Serial.println("[RadarTask] Wake → init I2C + radar...");
  
                  if (myRadar.begin(I2C_ADDR, Wire) != 1)
                  {
                      Serial.println("[RadarTask][ERROR] begin() failed! Suspending task.");
+                     logEvent(EVENT_ERROR, SOURCE_RADAR, ERROR_RADAR_BEGIN);
                  }
 
                  int32_t err = myRadar.distanceSetup(RANGE_MIN, RANGE_MAX);
@@ -44,19 +46,20 @@
                  {
                      Serial.print("[RadarTask][ERROR] distanceSetup() → ");
                      Serial.println(err);
+                     logEvent(EVENT_ERROR, SOURCE_RADAR, ERROR_RADAR_BEGIN, err);
                  }
  
                  Serial.printf("[RadarTask] Range set: %umm%umm\n", RANGE_MIN, RANGE_MAX);
-                 radarSleepReady.put(false);
+                 taskFlags.clear(FLAG_RADAR_SLEEP_READY);
                 // 1) cancel any tiny leakage echo near the start 
                  myRadar.setCloseRangeLeakageCancellation(true);
 
                  state = 1;
              }
          }
-         else if (state == 1 && !BluetoothConnected.get())  // ── Decide: sleep or measure ──
+         else if (state == 1)  // ── Decide: sleep or measure ──
          {
-             if (sleepFlag.get())
+             if (taskFlags.is_set(FLAG_SLEEP))
              {
                  Serial.println("[RadarTask] Sleep flag set → entering sleep");
                  state = 3;
@@ -74,6 +77,7 @@
              {
                  Serial.print("[RadarTask][ERROR] detectorReadingSetup() → ");
                  Serial.println(ret);
+                 logEvent(EVENT_ERROR, SOURCE_RADAR, ERROR_RADAR_MEASURE, ret);
                  // retry next cycle
              }
              else
@@ -116,9 +120,28 @@
                      {
                          float furthestCm = furthestMm * 0.1f;
                          Serial.printf("[RadarTask] Furthest peak: %.1f cm\n", furthestCm);
-                         // Store as integer cm
-                         distance.put((int16_t)furthestMm);
-                         dataReady.put(true);
+                         // Publish the whole sample at once for readers of lastSample
+                         SampleRecord sample;
+                         sample.time = unixTime.get();
+                         sample.distance = (int16_t)furthestMm;
+                         sample.battery = battery.get();
+                         sample.batteryPercent = batteryPercent.get();
+                         lastSample.put(sample);
+
+                         // Hand the sample to the SD task
+                         SDRequest request;
+                         request.type = SD_SAMPLE;
+                         request.sample = sample;
+                         if (!sdRequests.put(request))
+                         {
+                             Serial.println("[RadarTask][ERROR] SD queue full, sample dropped");
+                             droppedSamples++;
+                         }
+                         // The error needs a queue slot too, so it waits until there is room again
+                         else if (droppedSamples > 0 && logEvent(EVENT_ERROR, SOURCE_RADAR, ERROR_SD_QUEUE_FULL, SD_SAMPLE, droppedSamples))
+                         {
+                             droppedSamples = 0;
+                         }
                      }
                  }
              }
@@ -128,11 +151,18 @@
          {
              Serial.println("[RadarTask] Stopping detector and going to sleep...");
              myRadar.stop();
-             radarSleepReady.put(true);
-             state = 0;
+             taskFlags.set(FLAG_RADAR_SLEEP_READY);
+             state = 4;
+         }
+         else if (state == 4)  // ── Stopped, waiting for deep sleep ──
+         {
+             // Nothing left to measure, only keep the watchdog happy
+             watchChecks.set(CHECK_RADAR);
+             vTaskDelay(pdMS_TO_TICKS(WATCH_CHECK_PERIOD));
+             continue;
          }
  
-         radarCheck.put(true);
+         watchChecks.set(CHECK_RADAR);
          vTaskDelay(pdMS_TO_TICKS(RADAR_TASK_PERIOD));
      }
  }
\ No newline at end of file
@@ -14,180 +14,156 @@
 #include "setup.h"
 #include "sharedData.h"
 #include "waterSenseLibs/sdData/sdData.h"
+#include "waterSenseLibs/sdData/sdBus.h"
+#include "waterSenseLibs/eventLog/eventLog.h"
 /**
  * @brief The SD storage task
- * @details Creates relevant files on   the SD card and stores all data
+ * @details Creates relevant files on the SD card and stores all data. After
+ *          the files are created the task sleeps on the sdRequests queue and
+ *          only runs when another task sends it something to write. The card
+ *          is shared with the Bluetooth task through sdBus, which is held for
+ *          the whole of each request.
  * 
  * @param params A pointer to task parameters
  */
 void taskSD(void* params)
 {
   SD_Data mySD(SD_CS);
-  ExFile myFile;
-  ExFile GNSS;
+  EventLog eventLog;
 
   // Task Setup
   uint8_t state = 0;
+  bool sleepRequested = false; ///< SD_SLEEP has arrived
+  bool gnssEnded = false; ///< SD_GNSS_END has arrived
+  SDRequest request;
 
   // Task Loop
   while (true)
   {
-    if(writeFinishedSD.get() && BluetoothConnected.get()){
-      state = 6;//SUSPEND SD OPERATIONS
-      continue;
-    }
     // Begin
     if (state == 0)
     {
-      if (wakeReady.get())
+      // Nothing gets written before the wake, no need to time this out
+      if (taskFlags.wait_all(FLAG_WAKE_READY, portMAX_DELAY))
       {
+        sdBus.lock();
+
         // Check/create header files
         if ((wakeCounter % 1000) == 0)
         {
-          writeFinishedSD.put(false);
           mySD.writeHeader();
-          writeFinishedSD.put(true);
         }
 
+        eventLog.open();
+        if (esp_reset_reason() != ESP_RST_DEEPSLEEP)
+        {
+          eventLog.append(EVENT_BOOT, SOURCE_SD, esp_reset_reason());
+        }
+        EventRecord trip;
+        if (takeWatchdogTrip(trip))
+        {
+          eventLog.append(trip);
+        }
 
         if(inLongSurvey.get()==1){
-          writeFinishedSD.put(false);
-          GNSS = mySD.createGNSSFile();
-          writeFinishedSD.put(true);
+          if (!mySD.openGNSSFile())
+          {
+            eventLog.append(EVENT_ERROR, SOURCE_SD, ERROR_GNSS_FILE);
+          }
+        }
+        if (!mySD.openDataFile(unixTime.get()))
+        {
+          eventLog.append(EVENT_ERROR, SOURCE_SD, ERROR_DATA_FILE);
         }
-        writeFinishedSD.put(false);
-        myFile = mySD.createFile(unixTime.get());
-        writeFinishedSD.put(true);
+        mySD.syncData(true);
+        eventLog.sync();
+        sdBus.unlock();
 
-        fileCreated.put(true);
+        taskFlags.set(FLAG_FILE_CREATED);
 
         state = 1;
       }
-    }
-
-    // Check for data and populate buffer
-    else if (state == 1)
-    {
-      uint32_t gnssDataReadyValue = gnssDataReady.get();
-      if(inLongSurvey.get()==1){
-        if (gnssDataReadyValue) //hangs whyyyyyyy?
-        {//store gnss data, move on
-          gnssDataReady.put(false);
-          writeFinishedSD.put(false);
-      
-          String path = mySD.getGNSSFilePath();
-    
-          ExFile checkFile = SD.open(path.c_str(), O_RDONLY);
-          if (checkFile && checkFile.size() >= MAX_FILESIZE) {
-            Serial.println("GNSS file too large, creating new file");
-            checkFile.close();
-            GNSS = mySD.createGNSSFile(); // This should update the internal path
-            path = mySD.getGNSSFilePath(); // Get the new path
-          } else if (checkFile) {
-              checkFile.close();
-          }
-    
-          GNSS = SD.open(path.c_str(), O_RDWR | O_CREAT | O_APPEND);
-          mySD.writeGNSSData(GNSS, myBuffer);
-          mySD.sleep(GNSS);
-    
-          Serial.println("GNSS data written to SD card");
-    
-          writeFinishedSD.put(true);
-    
-        }
-      }
-      if(dataReady.get()){
-        dataReady.put(false);
-        state = 2;
-      }
-      // If sleepFlag is tripped, go to state 3
-      if (sleepFlag.get() && !gnssDataReadyValue)
+      else
       {
-        state = 3;
+        continue;
       }
     }
 
-    // Store data
-    else if (state == 2)
-    {
-      writeFinishedSD.put(false);
-      // Get sonar data
-      int16_t myDist = distance.get();
-
-      // Get voltages
-      float batteryP = batteryPercent.get();
-      float batteryVoltage = battery.get();
-
-      uint32_t myTime = unixTime.get();
-
-      // Write data to SD card
-      String path = mySD.getDataFilePath();
-
-      ExFile checkFile = SD.open(path.c_str(), O_RDONLY);
-      if (checkFile && checkFile.size() >= MAX_FILESIZE) {
-        checkFile.close();
-        myFile = mySD.createFile(unixTime.get()); // This should update the internal path
-        path = mySD.getDataFilePath(); // Get the new path
-      } else if (checkFile) {
-          checkFile.close();
-      }
-
-      myFile = SD.open(path.c_str(), O_RDWR | O_CREAT | O_APPEND);
-      mySD.writeData(myFile, myDist, myTime, batteryVoltage, batteryP);
-      mySD.sleep(myFile);
-
-      // Print data to serial monitor
-      Serial.printf("%d, %d, %0.2f, %0.2f, %0.2f, %0.2f\n", myTime, myDist, batteryVoltage, batteryP);
-      Serial.println(myTime);
+    // Sleep until a request arrives, checking in with the watchdog now and then
+    bool received = xQueueReceive(sdRequests.get_handle(), &request, pdMS_TO_TICKS(SD_IDLE_TIMEOUT)) == pdTRUE;
+    sdBus.lock();
 
-      writeFinishedSD.put(true);
-
-      state = 1;
-    }
-
-    // Write Log
-    else if (state == 3)
+    // Write requests
+    if (state == 1 && received)
     {
-      writeFinishedSD.put(false);
-      // If we have a fix, write data to the log
-      if (fixType.get())
+      if (request.type == SD_SAMPLE)
       {
-        Serial.printf("Writing log file Time: %s\n", displayTime.get());
-        uint32_t tim = unixTime.get();
-        int32_t lat = latitude.get();
-        int32_t lon = longitude.get();
-        int32_t alt = altitude.get();
+        // Append to the open data file, rolling over when it gets too large
+        SampleRecord &sample = request.sample;
+        mySD.appendData(sample.distance, sample.time, sample.battery, sample.batteryPercent);
 
-        mySD.writeLog(tim, wakeCounter, lat, lon, alt);
-
-        writeFinishedSD.put(true);
+        // Print data to serial monitor
+        Serial.printf("%u, %d, %0.2f, %0.2f\n", sample.time, sample.distance, sample.battery, sample.batteryPercent);
       }
+      else if (request.type == SD_GNSS_BLOCK)
+      {
+        // Append to the open GNSS file, rolling over when it gets too large, then hand the buffer back
+        mySD.writeGNSSData(gnssBuffers.data(request.gnss.slot), request.gnss.length);
+        gnssBuffers.release(request.gnss.slot);
 
-      state = 4;
+        Serial.println("GNSS data written to SD card");
+      }
+      else if (request.type == SD_GNSS_END)
+      {
+        gnssEnded = true;
+      }
+      else if (request.type == SD_EVENT)
+      {
+        eventLog.append(request.event);
+      }
+      else if (request.type == SD_FLUSH)
+      {
+        // Everything, the partial sector too, so the samples are on the card with the events
+        mySD.syncData(true);
+        eventLog.sync();
+      }
+      else if (request.type == SD_SLEEP)
+      {
+        sleepRequested = true;
+      }
+      else if (request.type == SD_ROLLOVER)
+      {
+        mySD.rolloverDataFile(unixTime.get());
+        taskFlags.set(FLAG_SD_ROLLOVER_DONE);
+      }
     }
 
     // Sleep
-    else if (state == 4)
+    else if (state == 4 && received)
     {
-      // Close data file
-      mySD.sleep(myFile);
-      mySD.sleep(GNSS);
-      sdSleepReady.put(true);
+      // Files are closed, nothing else gets written this wake
+      if (request.type == SD_GNSS_BLOCK)
+      {
+        gnssBuffers.drop(request.gnss.slot);
+      }
+      else if (request.type == SD_ROLLOVER)
+      {
+        taskFlags.set(FLAG_SD_ROLLOVER_DONE);
+      }
     }
 
-    else if(state == 6)//suspend sd operations(not sleep)
+    // Once asked to sleep and the last GNSS bytes are written, go to state 4
+    if (state == 1 && sleepRequested && (inLongSurvey.get() != 1 || gnssEnded))
     {
-      // Close data file
-      mySD.sleep(myFile);
-      mySD.sleep(GNSS);
-      sdSleepReady.put(true);
-      if(BluetoothConnected.get() == false){
-        state = 1;
-      }
+      // Close data files
+      mySD.sleep();
+      eventLog.append(EVENT_SLEEP, SOURCE_SD, millis());
+      eventLog.close();
+      taskFlags.set(FLAG_SD_SLEEP_READY);
+      state = 4;
     }
+    sdBus.unlock();
 
-    sdCheck.put(true);
-    vTaskDelay(SD_PERIOD);
+    watchChecks.set(CHECK_SD);
   }
-}
\ No newline at end of file
+}
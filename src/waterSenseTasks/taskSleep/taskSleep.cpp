@@ -17,7 +17,9 @@
 
 /**
  * @brief The sleep task
- * @details Sets the sleep time and triggers sleep
+ * @details Sets the sleep time and triggers sleep. Blocks on taskFlags while
+ *          waiting for the wake and for the other tasks, and sleeps out the
+ *          run time, checking in with the watchdog every WATCH_CHECK_PERIOD.
  * 
  * @param params A pointer to task parameters
  */
@@ -26,6 +28,8 @@ void taskSleep(void* params)
   // Task Setup
   uint8_t state = 0;
   uint64_t runTimer = millis();
+  int8_t longSurvey = -1;
+  uint32_t longSurveySeen = 0; ///< Version of inLongSurvey last read
 
   // Task Loop
   while (true)
@@ -33,7 +37,7 @@ void taskSleep(void* params)
     // Begin
     if (state == 0)
     {
-      if (wakeReady.get() && fileCreated.get())
+      if (taskFlags.wait_all(FLAG_WAKE_READY | FLAG_FILE_CREATED, pdMS_TO_TICKS(WATCH_CHECK_PERIOD)))
       {
         // Start run timer
         runTimer = millis();
@@ -42,11 +46,13 @@ void taskSleep(void* params)
         wakeCounter++;
 
         // Make sure sleep flag is not set
-        sleepFlag.put(false);
+        taskFlags.clear(FLAG_SLEEP);
 
-        Serial.printf("Wakeup number %d Time: %s\n", wakeCounter, displayTime.get());
+        logEvent(EVENT_WAKE, SOURCE_SLEEP, battery.get() * 1000, batteryPercent.get() * 100);
 
-        Serial.printf("Sleep state 0 -> 1 Time: %s\n", displayTime.get());
+        Serial.printf("Wakeup number %d Time: %s\n", wakeCounter, displayTime.get().c_str());
+
+        Serial.printf("Sleep state 0 -> 1 Time: %s\n", displayTime.get().c_str());
         state = 1;
       }
     }
@@ -56,27 +62,48 @@ void taskSleep(void* params)
     {
       // If runTimer, go to state 2
       uint32_t myReadTime = READ_TIME.get();
-      while(inLongSurvey.get()!=1&&inLongSurvey.get()!=0){vTaskDelay(10);};//if long survey task is hanging
-      if(inLongSurvey.get()==1){
+      inLongSurvey.get_if_newer(longSurvey, longSurveySeen);
+      while(longSurvey!=1&&longSurvey!=0){//if long survey task is hanging
+        inLongSurvey.wait_for_change(longSurvey, longSurveySeen, pdMS_TO_TICKS(WATCH_CHECK_PERIOD));
+        watchChecks.set(CHECK_SLEEP);
+      }
+      if(longSurvey==1){
         myReadTime =  GNSS_READ_TIME;
       }
-      if (((millis() - runTimer) > myReadTime*1000) )//|| (batteryPercent.get()<10))//if battery percent is too low
+      uint32_t elapsed = millis() - runTimer;
+      if (elapsed > myReadTime*1000)//|| (batteryPercent.get()<10))//if battery percent is too low
       {
-        Serial.printf("Sleep state 1 -> 2 Time: %s\n", displayTime.get());
+        Serial.printf("Sleep state 1 -> 2 Time: %s\n", displayTime.get().c_str());
 
         // Set sleep flag
-        sleepFlag.put(true);
+        taskFlags.set(FLAG_SLEEP);
+
+        // Ask the SD task to close its files once everything is written. It
+        // never sets FLAG_SD_SLEEP_READY without this, so wait for room in the
+        // queue rather than drop it, a hung SD task trips the watchdog itself
+        SDRequest request;
+        request.type = SD_SLEEP;
+        while (!sdRequests.put(request))
+        {
+          watchChecks.set(CHECK_SLEEP);
+        }
         state = 2;
       }
+      else
+      {
+        // Nothing to do until the run time is up
+        uint32_t remaining = myReadTime*1000 - elapsed + 1;
+        vTaskDelay(pdMS_TO_TICKS(remaining < WATCH_CHECK_PERIOD ? remaining : WATCH_CHECK_PERIOD));
+      }
     }
 
     // Initiate Sleep
     else if (state == 2)
     {
       // If all tasks are ready to sleep, go to state 3
-      if (radarSleepReady.get() && clockSleepReady.get() && sdSleepReady.get() && bluetoothSleepReady.get())
+      if (taskFlags.wait_all(FLAGS_SLEEP_READY, pdMS_TO_TICKS(WATCH_CHECK_PERIOD)))
       {
-        Serial.printf("Sleep state 2 -> 3 Time: %s\n", displayTime.get());
+        Serial.printf("Sleep state 2 -> 3 Time: %s\n", displayTime.get().c_str());
         state = 3;
       }
     }
@@ -95,7 +122,7 @@ void taskSleep(void* params)
       Serial.printf("Going to sleep for ");
       Serial.print(sleepTime.get()/1000000);
       Serial.println(" seconds");
-      // Serial.printf(" seconds Time: %s\n", displayTime.get());
+      // Serial.printf(" seconds Time: %s\n", displayTime.get().c_str());
 
       if ((sleepTime.get()/1000000) > (MINUTE_ALLIGN.get()*60))
       {
@@ -122,7 +149,6 @@ void taskSleep(void* params)
       esp_deep_sleep_start();
     }
 
-    sleepCheck.put(true);
-    vTaskDelay(SLEEP_PERIOD);
+    watchChecks.set(CHECK_SLEEP);
   }
 }
\ No newline at end of file
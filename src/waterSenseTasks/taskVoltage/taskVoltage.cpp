@@ -34,7 +34,7 @@ void taskVoltage(void* params)
     battery.put(4.1);
     batteryPercent.put(99);
     
-    voltageCheck.put(true);
+    watchChecks.set(CHECK_VOLTAGE);
     vTaskDelay(VOLTAGE_PERIOD);
     // // Measure voltage
     // if(state==0){
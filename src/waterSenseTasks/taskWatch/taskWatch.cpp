@@ -24,15 +24,7 @@
 void taskWatch(void* params)
 {
   // Task Setup
-  bool clock = false;
-  bool sd = false;
-  bool voltage = false;
-  bool sleep = false;
-  bool measure = false;
-  bool gnss = false;
-  bool bluetooth = false;
-
-  uint32_t taskTimer = millis();
+  WatchCheck checks = (WatchCheck) 0;
 
   uint8_t state = 0;
 
@@ -42,9 +34,9 @@ void taskWatch(void* params)
     // Begin
     if (state == 0)
     {
-        if (wakeReady.get())
+        // Nothing is watched until the wake, no need to time this out
+        if (taskFlags.wait_all(FLAG_WAKE_READY, portMAX_DELAY))
         {
-          taskTimer = millis();
           state = 1;
         }
     }
@@ -52,37 +44,18 @@ void taskWatch(void* params)
     // Check Tasks
     else if (state == 1)
     {
-      // Check tasks
-      clock = clockCheck.get();
-      sd = sdCheck.get();
-      voltage = voltageCheck.get();
-      sleep = sleepCheck.get();
-      measure = radarCheck.get();
-      bluetooth = bluetoothCheck.get();
-      // If all tasks are good, reset the timer
-      if (clock && sd && voltage && sleep && measure && bluetooth)
-      {
-          // Reset timer
-          taskTimer = millis();
-
-          // Reset checks
-          clockCheck.put(false);
-          sdCheck.put(false);
-          voltageCheck.put(false);
-          sleepCheck.put(false);
-          radarCheck.put(false);
-          bluetoothCheck.put(false);
-      }
-      // Otherwise, check the timer
-      else if ((millis() - taskTimer) > WATCH_TIMER)
+      // Sleep until every task has checked in, which restarts the timer, or
+      // until the timer runs out
+      if (!watchChecks.wait_all(CHECKS_ALL, pdMS_TO_TICKS(WATCH_TIMER), true))
       {
+        checks = watchChecks.get();
         Serial.printf("Status - Clock: %s | SD: %s | Voltage: %s | Sleep: %s | Measure: %s | Bluetooth: %s\n",
-          clock ? "true" : "false",
-          sd ? "true" : "false",
-          voltage ? "true" : "false",
-          sleep ? "true" : "false",
-          measure ? "true" : "false",
-          bluetooth ? "true" : "false");
+          (checks & CHECK_CLOCK) ? "true" : "false",
+          (checks & CHECK_SD) ? "true" : "false",
+          (checks & CHECK_VOLTAGE) ? "true" : "false",
+          (checks & CHECK_SLEEP) ? "true" : "false",
+          (checks & CHECK_RADAR) ? "true" : "false",
+          (checks & CHECK_BLUETOOTH) ? "true" : "false");
           state = 2;
       }
     }
@@ -90,12 +63,12 @@ void taskWatch(void* params)
     // Abort Program
     else if (state == 2)
     {
-        Serial.printf("Watchdog Timer Tripped! Time: %s\n", displayTime.get());
+        Serial.printf("Watchdog Timer Tripped! Time: %s\n", displayTime.get().c_str());
+        // Bits follow the status line above, the trip is logged after the reset
+        noteWatchdogTrip(unixTime.get(), ~checks & CHECKS_ALL);
         Serial.flush();
         assert(false);
         state = 0;
     }
-    
-    vTaskDelay(WATCHDOG_PERIOD);
   }
 }
\ No newline at end of file
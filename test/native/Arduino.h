@@ -0,0 +1,248 @@
+/**
+ * @file Arduino.h
+ * @brief Host stand-in for the parts of the ESP32 Arduino core and FreeRTOS
+ *        the firmware libraries use
+ * @details Tasks are std::threads, queues, mutexes and event groups block on
+ *          condition variables and a tick is a millisecond. Critical sections
+ *          take one lock shared by every portMUX, which is what disabling
+ *          interrupts on a single core amounts to.
+ *
+ *          hostSimulateTime() switches the clock over to simulated time for
+ *          single threaded tests of a task: nothing blocks, a call that would
+ *          wait moves the clock on and calls the test back instead.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <assert.h>
+#include <string>
+
+#define ESP32 1
+
+//-----------------------------------------------------------------------------------------------------||
+//---------- ESP32 ------------------------------------------------------------------------------------||
+
+typedef int gpio_num_t;
+#define GPIO_NUM_5 5
+#define GPIO_NUM_6 6
+#define OUTPUT 1
+#define INPUT 0
+#define HIGH 1
+#define LOW 0
+#define HEX 16
+#define DEC 10
+#define F(x) x
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define IRAM_ATTR
+
+enum esp_reset_reason_t { ESP_RST_UNKNOWN, ESP_RST_POWERON, ESP_RST_EXT, ESP_RST_SW, ESP_RST_PANIC,
+                          ESP_RST_INT_WDT, ESP_RST_TASK_WDT, ESP_RST_WDT, ESP_RST_DEEPSLEEP };
+esp_reset_reason_t esp_reset_reason(void);
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+
+//-----------------------------------------------------------------------------------------------------||
+//---------- FreeRTOS ---------------------------------------------------------------------------------||
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t EventBits_t;
+typedef void* QueueHandle_t;
+typedef void* SemaphoreHandle_t;
+typedef void* TaskHandle_t;
+typedef void* EventGroupHandle_t;
+
+#define portBASE_TYPE long
+#define portMAX_DELAY ((TickType_t) 0xffffffffUL)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t) (ms))
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define configASSERT(x) assert(x)
+
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+void hostEnterCritical(void);
+void hostExitCritical(void);
+#define portENTER_CRITICAL(mux) hostEnterCritical()
+#define portEXIT_CRITICAL(mux) hostExitCritical()
+#define portENTER_CRITICAL_ISR(mux) hostEnterCritical()
+#define portEXIT_CRITICAL_ISR(mux) hostExitCritical()
+#define portYIELD_FROM_ISR(wake) ((void) (wake))
+#define taskYIELD() ((void) 0)
+
+BaseType_t xPortInIsrContext(void);
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void* item, TickType_t ticks);
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticks);
+BaseType_t xQueueSendToBackFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken);
+BaseType_t xQueueSendToFrontFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken);
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void* item);
+BaseType_t xQueueOverwriteFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks);
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void* item, BaseType_t* woken);
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticks);
+BaseType_t xQueuePeekFromISR(QueueHandle_t queue, void* item);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+UBaseType_t uxQueueMessagesWaitingFromISR(QueueHandle_t queue);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue);
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex);
+
+EventGroupHandle_t xEventGroupCreate(void);
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupSetBitsFromISR(EventGroupHandle_t group, EventBits_t bits, BaseType_t* woken);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupClearBitsFromISR(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group);
+EventBits_t xEventGroupGetBitsFromISR(EventGroupHandle_t group);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear,
+                                BaseType_t all, TickType_t ticks);
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+TickType_t xTaskGetTickCount(void);
+void vTaskDelay(TickType_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task);
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority);
+
+/**
+ * @brief Run the clock by hand from now on
+ * @details millis(), micros() and the tick count read a simulated clock that
+ *          starts at 0. Whatever would block moves it on by its timeout, or by
+ *          a tick, and then calls step with the new time. step may throw to
+ *          stop the code under test.
+ *
+ * @param step Called every time the clock moves, NULL to go back to real time
+ */
+void hostSimulateTime(void (*step)(uint64_t nowMs));
+
+/// Move the simulated clock on, as if the caller had blocked for ms
+void hostAdvance(uint32_t ms);
+
+//-----------------------------------------------------------------------------------------------------||
+//---------- Print and String -------------------------------------------------------------------------||
+
+class String;
+
+class Print
+{
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t* buffer, size_t size);
+        size_t write(const char* text) { return write((const uint8_t*) text, strlen(text)); }
+        size_t write(const char* buffer, size_t size) { return write((const uint8_t*) buffer, size); }
+
+        size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+        size_t print(const char* text);
+        size_t print(const String& text);
+        size_t print(char c);
+        size_t print(int value, int base = DEC);
+        size_t print(unsigned int value, int base = DEC);
+        size_t print(long value, int base = DEC);
+        size_t print(unsigned long value, int base = DEC);
+        size_t print(double value, int digits = 2);
+        size_t println(void);
+        size_t println(const char* text);
+        size_t println(const String& text);
+        size_t println(char c);
+        size_t println(int value, int base = DEC);
+        size_t println(unsigned int value, int base = DEC);
+        size_t println(long value, int base = DEC);
+        size_t println(unsigned long value, int base = DEC);
+        size_t println(double value, int digits = 2);
+};
+
+class String
+{
+    protected:
+        std::string text;
+
+    public:
+        String(const char* value = "") : text(value ? value : "") {}
+        String(const std::string& value) : text(value) {}
+        explicit String(char c) : text(1, c) {}
+        String(int value, unsigned char base = DEC);
+        String(unsigned int value, unsigned char base = DEC);
+        String(long value, unsigned char base = DEC);
+        String(unsigned long value, unsigned char base = DEC);
+        String(float value, unsigned char decimals = 2);
+        String(double value, unsigned char decimals = 2);
+
+        const char* c_str() const { return text.c_str(); }
+        unsigned int length() const { return text.size(); }
+        char operator[](unsigned int index) const { return index < text.size() ? text[index] : 0; }
+
+        String& operator+=(const String& other) { text += other.text; return *this; }
+        String& operator+=(const char* other) { text += other; return *this; }
+        String& operator+=(char c) { text += c; return *this; }
+        template <class T> String& operator+=(T value) { return *this += String(value); }
+        friend String operator+(const String& a, const String& b) { return String(a.text + b.text); }
+        friend String operator+(const String& a, const char* b) { return String(a.text + b); }
+        friend String operator+(const char* a, const String& b) { return String(a + b.text); }
+        template <class T> friend String operator+(const String& a, T b) { return a + String(b); }
+
+        bool operator==(const String& other) const { return text == other.text; }
+        bool operator==(const char* other) const { return text == other; }
+        bool operator!=(const String& other) const { return text != other.text; }
+        bool operator!=(const char* other) const { return text != other; }
+
+        bool startsWith(const String& prefix) const { return text.compare(0, prefix.text.size(), prefix.text) == 0; }
+        bool endsWith(const String& suffix) const;
+        int indexOf(char c, unsigned int from = 0) const;
+        int indexOf(const String& other, unsigned int from = 0) const;
+        String substring(unsigned int from) const;
+        String substring(unsigned int from, unsigned int to) const;
+        long toInt() const { return atol(text.c_str()); }
+        void trim();
+        void reserve(unsigned int size) { text.reserve(size); }
+};
+
+/**
+ * @brief The serial port, printed to stdout
+ * @details Set HOST_QUIET in the environment to keep the firmware's chatter
+ *          out of the test output
+ *
+ */
+class HardwareSerial : public Print
+{
+    public:
+        void begin(unsigned long baud) {}
+        void flush(void);
+        operator bool() const { return true; }
+        size_t write(uint8_t c);
+        size_t write(const uint8_t* buffer, size_t size);
+        using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif //HOST_ARDUINO_H
@@ -0,0 +1,173 @@
+/**
+ * @file ArduinoBLE.cpp
+ * @brief Host stand-in for ArduinoBLE, with a central the test plays
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <ArduinoBLE.h>
+
+BLELocalDevice BLE;
+HostCentral hostCentral;
+
+bool BLEDevice :: connected()
+{
+    return valid && hostCentral.linked;
+}
+
+//-----------------------------------------------------------------------------------------------------||
+//---------- Characteristics --------------------------------------------------------------------------||
+
+BLECharacteristic :: BLECharacteristic(const char* uuid, uint8_t properties, int valueSize, bool fixedLength)
+    : id(uuid), properties(properties)
+{
+    hostCentral.characteristics[id] = this;
+}
+
+BLECharacteristic :: ~BLECharacteristic()
+{
+    if (hostCentral.characteristics[id] == this) hostCentral.characteristics.erase(id);
+}
+
+int BLECharacteristic :: writeValue(const uint8_t* value, int length, bool withResponse)
+{
+    data.assign(value, value + length);
+    if (!(properties & (BLENotify | BLEIndicate))) return 1;
+
+    // A notification needs a subscribed central and a free buffer in the controller
+    if (!hostCentral.linked || !subscribed()) return 0;
+    if (hostCentral.accept && !hostCentral.accept(id, value, length)) return 0;
+
+    hostCentral.notified[id].push_back(std::string((const char*) value, length));
+    return 1;
+}
+
+int BLECharacteristic :: writeValue(const char* value, bool withResponse)
+{
+    return writeValue((const uint8_t*) value, strlen(value), withResponse);
+}
+
+bool BLECharacteristic :: subscribed()
+{
+    return hostCentral.subscriptions.count(id) > 0;
+}
+
+void BLECharacteristic :: setEventHandler(int event, BLECharacteristicEventHandler handler)
+{
+    if (event == BLEWritten) writtenHandler = handler;
+}
+
+void BLECharacteristic :: centralWrote(const std::string& value)
+{
+    data.assign(value.begin(), value.end());
+    if (writtenHandler) writtenHandler(BLEDevice(true), *this);
+}
+
+//-----------------------------------------------------------------------------------------------------||
+//---------- Local device -----------------------------------------------------------------------------||
+
+void BLELocalDevice :: poll()
+{
+    while (!hostCentral.pending.empty())
+    {
+        std::function<void()> next = hostCentral.pending.front();
+        hostCentral.pending.pop_front();
+        next();
+    }
+}
+
+void BLELocalDevice :: setAdvertisingInterval(uint16_t interval)
+{
+    hostCentral.advertisingInterval = interval;
+}
+
+int BLELocalDevice :: advertise()
+{
+    if (hostCentral.linked) return 0;
+    if (!hostCentral.advertising) hostCentral.advertisingSince = millis();
+    hostCentral.advertising = true;
+    return 1;
+}
+
+void BLELocalDevice :: stopAdvertise()
+{
+    hostCentral.advertising = false;
+}
+
+BLEDevice BLELocalDevice :: central()
+{
+    if (!hostCentral.linked) return BLEDevice();
+    if (!hostCentral.seenAt) hostCentral.seenAt = millis() ? millis() : 1;
+    return BLEDevice(true);
+}
+
+bool BLELocalDevice :: connected()
+{
+    return hostCentral.linked;
+}
+
+bool BLELocalDevice :: disconnect()
+{
+    hostCentral.disconnect();
+    return true;
+}
+
+void BLELocalDevice :: setEventHandler(BLEDeviceEvent event, BLEDeviceEventHandler handler)
+{
+    if (event == BLEConnected) hostCentral.connectedHandler = handler;
+    else hostCentral.disconnectedHandler = handler;
+}
+
+//-----------------------------------------------------------------------------------------------------||
+//---------- The central ------------------------------------------------------------------------------||
+
+void HostCentral :: connect()
+{
+    pending.push_back([this] {
+        if (linked) return;
+        linked = true;
+        advertising = false;
+        seenAt = 0;
+        if (connectedHandler) connectedHandler(BLEDevice(true));
+    });
+}
+
+void HostCentral :: disconnect()
+{
+    pending.push_back([this] {
+        if (!linked) return;
+        linked = false;
+        subscriptions.clear();
+        if (disconnectedHandler) disconnectedHandler(BLEDevice(true));
+    });
+}
+
+void HostCentral :: write(const char* uuid, const char* value)
+{
+    std::string id(uuid);
+    std::string text(value);
+    pending.push_back([this, id, text] {
+        if (linked && characteristics.count(id)) characteristics[id]->centralWrote(text);
+    });
+}
+
+const std::string& HostCentral :: last(const char* uuid)
+{
+    static const std::string none;
+    std::vector<std::string>& sent = notified[uuid];
+    return sent.empty() ? none : sent.back();
+}
+
+void HostCentral :: reset()
+{
+    linked = false;
+    advertising = false;
+    seenAt = 0;
+    subscriptions.clear();
+    notified.clear();
+    accept = NULL;
+    pending.clear();
+}
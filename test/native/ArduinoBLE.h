@@ -0,0 +1,167 @@
+/**
+ * @file ArduinoBLE.h
+ * @brief Host stand-in for ArduinoBLE, with a central the test plays
+ * @details Like the real library, nothing happens behind the task's back:
+ *          connections, disconnections and writes from the central are only
+ *          seen, and their handlers only run, inside BLE.poll(). A
+ *          notification goes out only while the central is connected and
+ *          subscribed to the characteristic, otherwise writeValue() returns 0.
+ *
+ *          The test drives hostCentral, usually from the hostSimulateTime()
+ *          step, and reads back what was notified.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef HOST_ARDUINO_BLE_H
+#define HOST_ARDUINO_BLE_H
+
+#include <Arduino.h>
+#include <deque>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+enum BLEProperty
+{
+    BLEBroadcast = 0x01,
+    BLERead = 0x02,
+    BLEWriteWithoutResponse = 0x04,
+    BLEWrite = 0x08,
+    BLENotify = 0x10,
+    BLEIndicate = 0x20
+};
+
+enum BLEDeviceEvent
+{
+    BLEConnected,
+    BLEDisconnected
+};
+
+enum BLECharacteristicEvent
+{
+    BLESubscribed,
+    BLEUnsubscribed,
+    BLEWritten
+};
+
+class BLEDevice
+{
+    protected:
+        bool valid;
+
+    public:
+        BLEDevice(bool valid = false) : valid(valid) {}
+        operator bool() const { return valid; }
+        String address(void) { return valid ? "00:11:22:33:44:55" : ""; }
+        bool connected(void);
+};
+
+class BLECharacteristic;
+typedef void (*BLEDeviceEventHandler)(BLEDevice device);
+typedef void (*BLECharacteristicEventHandler)(BLEDevice device, BLECharacteristic characteristic);
+
+class BLECharacteristic
+{
+    protected:
+        std::string id;
+        uint8_t properties;
+        std::vector<uint8_t> data;
+        BLECharacteristicEventHandler writtenHandler = NULL;
+
+    public:
+        BLECharacteristic(const char* uuid, uint8_t properties, int valueSize, bool fixedLength = false);
+        BLECharacteristic(const BLECharacteristic& other) = default;
+        ~BLECharacteristic();
+
+        const char* uuid(void) const { return id.c_str(); }
+        int writeValue(const uint8_t* value, int length, bool withResponse = true);
+        int writeValue(const char* value, bool withResponse = true);
+        int valueLength(void) const { return data.size(); }
+        const uint8_t* value(void) const { return data.data(); }
+        bool subscribed(void);
+        void setEventHandler(int event, BLECharacteristicEventHandler handler);
+
+        void centralWrote(const std::string& value); ///< Host only, the central wrote the value
+};
+
+class BLEStringCharacteristic : public BLECharacteristic
+{
+    public:
+        BLEStringCharacteristic(const char* uuid, uint8_t properties, int valueSize)
+            : BLECharacteristic(uuid, properties, valueSize) {}
+
+        int writeValue(const String& value) { return BLECharacteristic::writeValue(value.c_str()); }
+        String value(void) const { return String(std::string(data.begin(), data.end())); }
+};
+
+class BLEService
+{
+    public:
+        BLEService(const char* uuid) {}
+        void addCharacteristic(BLECharacteristic& characteristic) {}
+};
+
+class BLELocalDevice
+{
+    public:
+        int begin(void) { return 1; }
+        void end(void) {}
+        void poll(void);
+        void poll(unsigned long timeout) { poll(); }
+        void setLocalName(const char* name) {}
+        void setAdvertisedServiceUuid(const char* uuid) {}
+        void setAdvertisedService(BLEService& service) {}
+        void addService(BLEService& service) {}
+        void setAdvertisingInterval(uint16_t interval);
+        void setConnectionInterval(uint16_t minimum, uint16_t maximum) {}
+        int advertise(void);
+        void stopAdvertise(void);
+        BLEDevice central(void);
+        bool connected(void);
+        bool disconnect(void);
+        void setEventHandler(BLEDeviceEvent event, BLEDeviceEventHandler handler);
+};
+
+extern BLELocalDevice BLE;
+
+/**
+ * @brief The central on the other end, played by the test
+ *
+ */
+class HostCentral
+{
+    public:
+        bool linked = false; ///< Connected as far as the task has seen, changes in BLE.poll()
+        bool advertising = false; ///< Whether the peripheral is advertising
+        unsigned long advertisingSince = 0; ///< millis() when advertising last started
+        uint16_t advertisingInterval = 160; ///< In 0.625 ms units, ArduinoBLE's default is 100 ms
+        unsigned long seenAt = 0; ///< millis() when BLE.central() first returned this connection, 0 until it has
+        std::set<std::string> subscriptions; ///< UUIDs the central has notifications on for
+        std::map<std::string, std::vector<std::string>> notified; ///< Every notification sent, by UUID
+
+        /// Called for every notification that could go out, return false for "no buffer free"
+        std::function<bool(const std::string& uuid, const uint8_t* data, int length)> accept;
+
+        void connect(void); ///< Connect, seen at the next poll
+        void disconnect(void); ///< Drop the link, seen at the next poll
+        void subscribe(const char* uuid) { subscriptions.insert(uuid); }
+        void write(const char* uuid, const char* value); ///< Write a characteristic, seen at the next poll
+        const std::string& last(const char* uuid); ///< The last notification on a characteristic
+        void reset(void); ///< Forget everything, for the next test
+
+        // Used by the stand-in itself
+        std::map<std::string, BLECharacteristic*> characteristics;
+        std::deque<std::function<void()>> pending;
+        BLEDeviceEventHandler connectedHandler = NULL;
+        BLEDeviceEventHandler disconnectedHandler = NULL;
+};
+
+extern HostCentral hostCentral;
+
+#endif //HOST_ARDUINO_BLE_H
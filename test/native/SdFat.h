@@ -0,0 +1,109 @@
+/**
+ * @file SdFat.h
+ * @brief Host stand-in for SdFat's exFAT volume and file classes, on a
+ *        RamBlockDevice
+ * @details Only the calls the firmware makes are here, and they behave the
+ *          way SdFat's do where it matters to the card:
+ *          - one sector cache per volume. A partial sector is read, changed
+ *            in the cache and written back when another sector is needed or
+ *            on sync().
+ *          - whole, sector aligned pieces of a write go straight to the card.
+ *          - sync() and close() write the directory entry of a file that
+ *            grew, and the allocation bitmap if clusters were allocated.
+ *          - preAllocate() takes one contiguous run up front and truncate()
+ *            hands back everything past the end.
+ *          - directory positions step over exFAT entry sets, 32 bytes per
+ *            entry, so cursors taken from curPosition() can be sought back to.
+ *          A cluster is one sector. Names compare without regard to case.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef HOST_SDFAT_H
+#define HOST_SDFAT_H
+
+#include <Arduino.h>
+#include <fcntl.h>
+#include <memory>
+#include "ramBlockDevice.h"
+
+typedef int oflag_t;
+
+#ifndef O_READ
+    #define O_READ O_RDONLY
+#endif
+#ifndef O_WRITE
+    #define O_WRITE O_WRONLY
+#endif
+
+#define SD_SCK_MHZ(mhz) (1000000UL * (mhz))
+
+struct RamNode;
+
+class ExFile : public Print
+{
+    protected:
+        std::shared_ptr<RamNode> node; ///< The file or directory, NULL when closed
+        uint64_t position = 0; ///< Byte offset in a file, entry set offset in a directory
+        oflag_t flags = 0; ///< The flags the file was opened with
+
+        bool writable(void) const;
+
+    public:
+        bool open(const char* path, oflag_t oflag = O_RDONLY);
+        bool openNext(ExFile* dir, oflag_t oflag = O_RDONLY);
+        bool close(void);
+        bool remove(void);
+
+        bool isOpen(void) const { return node != NULL; }
+        operator bool(void) const { return isOpen(); }
+        bool isDirectory(void) const;
+        bool isDir(void) const { return isDirectory(); }
+        bool isFile(void) const { return isOpen() && !isDirectory(); }
+        size_t getName(char* name, size_t size);
+
+        uint64_t fileSize(void) const;
+        uint64_t size(void) const { return fileSize(); }
+        uint64_t curPosition(void) const { return position; }
+        bool seekSet(uint64_t pos);
+        bool seekCur(int64_t offset) { return seekSet(position + offset); }
+        bool seekEnd(int64_t offset = 0) { return seekSet(fileSize() + offset); }
+        int available(void) const;
+
+        int read(void);
+        int read(void* buffer, size_t count);
+        int fgets(char* str, int num, char* delim = NULL);
+
+        size_t write(const void* buffer, size_t count);
+        size_t write(uint8_t b) { return write(&b, 1); }
+        size_t write(const uint8_t* buffer, size_t count) { return write((const void*) buffer, count); }
+        using Print::write;
+
+        bool sync(void);
+        bool preAllocate(uint64_t length);
+        bool truncate(void);
+        bool truncate(uint64_t length);
+        uint32_t firstSector(void) const; ///< First sector of a contiguous file, 0 if it is not contiguous
+};
+
+typedef ExFile File;
+
+class SdFat
+{
+    public:
+        bool begin(int csPin, uint32_t maxSck); ///< A method to mount the card, always works
+        bool format(void); ///< A method to erase the card and everything on it
+
+        ExFile open(const char* path, oflag_t oflag = O_RDONLY);
+        ExFile open(const String& path, oflag_t oflag = O_RDONLY) { return open(path.c_str(), oflag); }
+        bool exists(const char* path);
+        bool mkdir(const char* path, bool pFlag = true);
+        bool remove(const char* path);
+
+        RamBlockDevice* card(void); ///< The RAM card under the volume
+};
+
+#endif //HOST_SDFAT_H
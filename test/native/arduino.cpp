@@ -0,0 +1,163 @@
+/**
+ * @file arduino.cpp
+ * @brief Host stand-in for Print, String and the serial port
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include <stdarg.h>
+
+HardwareSerial Serial;
+
+static bool quiet = getenv("HOST_QUIET") != NULL;
+
+size_t Print::write(const uint8_t* buffer, size_t size)
+{
+    size_t written = 0;
+    while (written < size && write(buffer[written])) written++;
+    return written;
+}
+
+size_t Print::printf(const char* format, ...)
+{
+    char stack[128];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(stack, sizeof(stack), format, args);
+    va_end(args);
+    if (length < 0) return 0;
+    if ((size_t) length < sizeof(stack)) return write((const uint8_t*) stack, length);
+
+    std::string heap(length + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&heap[0], heap.size(), format, args);
+    va_end(args);
+    return write((const uint8_t*) heap.data(), length);
+}
+
+size_t Print::print(const char* text) { return write(text); }
+size_t Print::print(const String& text) { return write(text.c_str()); }
+size_t Print::print(char c) { return write((uint8_t) c); }
+size_t Print::print(int value, int base) { return print(String(value, base)); }
+size_t Print::print(unsigned int value, int base) { return print(String(value, base)); }
+size_t Print::print(long value, int base) { return print(String(value, base)); }
+size_t Print::print(unsigned long value, int base) { return print(String(value, base)); }
+size_t Print::print(double value, int digits) { return print(String(value, digits)); }
+size_t Print::println(void) { return write("\r\n"); }
+size_t Print::println(const char* text) { return print(text) + println(); }
+size_t Print::println(const String& text) { return print(text) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(int value, int base) { return print(value, base) + println(); }
+size_t Print::println(unsigned int value, int base) { return print(value, base) + println(); }
+size_t Print::println(long value, int base) { return print(value, base) + println(); }
+size_t Print::println(unsigned long value, int base) { return print(value, base) + println(); }
+size_t Print::println(double value, int digits) { return print(value, digits) + println(); }
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size)
+{
+    if (!quiet) fwrite(buffer, 1, size, stdout);
+    return size;
+}
+
+void HardwareSerial::flush()
+{
+    fflush(stdout);
+}
+
+static std::string formatNumber(unsigned long long magnitude, bool negative, unsigned char base)
+{
+    const char digits[] = "0123456789abcdef";
+    if (base < 2 || base > 16) base = 10;
+
+    std::string text;
+    do
+    {
+        text.insert(text.begin(), digits[magnitude % base]);
+        magnitude /= base;
+    } while (magnitude);
+    if (negative) text.insert(text.begin(), '-');
+    return text;
+}
+
+// Arduino prints negative numbers in any base other than 10 as their two's complement
+String::String(int value, unsigned char base)
+    : text(base == DEC ? formatNumber(value < 0 ? -(long long) value : value, value < 0, base)
+                       : formatNumber((unsigned int) value, false, base)) {}
+String::String(unsigned int value, unsigned char base) : text(formatNumber(value, false, base)) {}
+String::String(long value, unsigned char base)
+    : text(base == DEC ? formatNumber(value < 0 ? -(long long) value : value, value < 0, base)
+                       : formatNumber((unsigned long) value, false, base)) {}
+String::String(unsigned long value, unsigned char base) : text(formatNumber(value, false, base)) {}
+
+String::String(float value, unsigned char decimals)
+{
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    text = buffer;
+}
+
+String::String(double value, unsigned char decimals)
+{
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    text = buffer;
+}
+
+bool String::endsWith(const String& suffix) const
+{
+    return text.size() >= suffix.text.size()
+        && text.compare(text.size() - suffix.text.size(), suffix.text.size(), suffix.text) == 0;
+}
+
+int String::indexOf(char c, unsigned int from) const
+{
+    size_t found = text.find(c, from);
+    return found == std::string::npos ? -1 : (int) found;
+}
+
+int String::indexOf(const String& other, unsigned int from) const
+{
+    size_t found = text.find(other.text, from);
+    return found == std::string::npos ? -1 : (int) found;
+}
+
+String String::substring(unsigned int from) const
+{
+    return from >= text.size() ? String() : String(text.substr(from));
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+    if (from > to) std::swap(from, to);
+    if (from >= text.size()) return String();
+    return String(text.substr(from, to - from));
+}
+
+void String::trim()
+{
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos)
+    {
+        text.clear();
+        return;
+    }
+    size_t last = text.find_last_not_of(" \t\r\n");
+    text = text.substr(first, last - first + 1);
+}
+
+esp_reset_reason_t esp_reset_reason()
+{
+    return ESP_RST_POWERON;
+}
+
+void pinMode(int pin, int mode) {}
+void digitalWrite(int pin, int value) {}
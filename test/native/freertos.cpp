@@ -0,0 +1,390 @@
+/**
+ * @file freertos.cpp
+ * @brief Host stand-in for the FreeRTOS calls the firmware uses, on std::thread
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static const Clock::time_point started = Clock::now();
+static void (*simulatedStep)(uint64_t) = NULL;
+static uint64_t simulatedMs = 0;
+static std::recursive_mutex critical;
+
+//-----------------------------------------------------------------------------------------------------||
+//---------- Time -------------------------------------------------------------------------------------||
+
+void hostSimulateTime(void (*step)(uint64_t nowMs))
+{
+    simulatedStep = step;
+    simulatedMs = 0;
+}
+
+void hostAdvance(uint32_t ms)
+{
+    simulatedMs += ms;
+    if (simulatedStep) simulatedStep(simulatedMs);
+}
+
+unsigned long millis()
+{
+    if (simulatedStep) return simulatedMs;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - started).count();
+}
+
+unsigned long micros()
+{
+    if (simulatedStep) return simulatedMs * 1000;
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - started).count();
+}
+
+void delay(unsigned long ms)
+{
+    vTaskDelay(ms);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    if (!simulatedStep) std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+TickType_t xTaskGetTickCount()
+{
+    return millis();
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (simulatedStep)
+    {
+        hostAdvance(ticks ? ticks : 1);
+    }
+    else if (ticks)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+    }
+    else
+    {
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * @brief Block until ready() holds or ticks run out
+ * @details With simulated time the clock jumps by the whole timeout, or a tick
+ *          at a time for portMAX_DELAY, and ready() is checked again after each
+ *          jump
+ *
+ * @param lock Holds the mutex that guards whatever ready() looks at
+ * @param changed Signalled whenever that changes
+ * @param ticks The most ticks to wait
+ * @param ready Whether the caller can go on
+ * @return The last result of ready()
+ */
+template <class Ready>
+static bool waitUntil(std::unique_lock<std::mutex>& lock, std::condition_variable& changed, TickType_t ticks, Ready ready)
+{
+    if (ready()) return true;
+    if (ticks == 0) return false;
+
+    if (simulatedStep)
+    {
+        do
+        {
+            lock.unlock();
+            hostAdvance(ticks == portMAX_DELAY ? 1 : ticks);
+            lock.lock();
+        } while (ticks == portMAX_DELAY && !ready());
+        return ready();
+    }
+
+    if (ticks == portMAX_DELAY)
+    {
+        changed.wait(lock, ready);
+        return true;
+    }
+    return changed.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+
+//-----------------------------------------------------------------------------------------------------||
+//---------- Critical sections and ISRs ---------------------------------------------------------------||
+
+void hostEnterCritical()
+{
+    critical.lock();
+}
+
+void hostExitCritical()
+{
+    critical.unlock();
+}
+
+BaseType_t xPortInIsrContext()
+{
+    return pdFALSE;
+}
+
+//-----------------------------------------------------------------------------------------------------||
+//---------- Queues -----------------------------------------------------------------------------------||
+
+struct HostQueue
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length;
+    size_t itemSize;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    HostQueue* queue = new HostQueue;
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+static BaseType_t send(QueueHandle_t handle, const void* item, TickType_t ticks, bool front)
+{
+    HostQueue* queue = (HostQueue*) handle;
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!waitUntil(lock, queue->changed, ticks, [queue] { return queue->items.size() < queue->length; }))
+    {
+        return pdFALSE;
+    }
+
+    std::vector<uint8_t> copy((const uint8_t*) item, (const uint8_t*) item + queue->itemSize);
+    if (front) queue->items.push_front(copy);
+    else queue->items.push_back(copy);
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+static BaseType_t receive(QueueHandle_t handle, void* item, TickType_t ticks, bool remove)
+{
+    HostQueue* queue = (HostQueue*) handle;
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!waitUntil(lock, queue->changed, ticks, [queue] { return !queue->items.empty(); }))
+    {
+        return pdFALSE;
+    }
+
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    if (remove)
+    {
+        queue->items.pop_front();
+        queue->changed.notify_all();
+    }
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void* item, TickType_t ticks) { return send(queue, item, ticks, false); }
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticks) { return send(queue, item, ticks, true); }
+BaseType_t xQueueSendToBackFromISR(QueueHandle_t queue, const void* item, BaseType_t*) { return send(queue, item, 0, false); }
+BaseType_t xQueueSendToFrontFromISR(QueueHandle_t queue, const void* item, BaseType_t*) { return send(queue, item, 0, true); }
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) { return receive(queue, item, ticks, true); }
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void* item, BaseType_t*) { return receive(queue, item, 0, true); }
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticks) { return receive(queue, item, ticks, false); }
+BaseType_t xQueuePeekFromISR(QueueHandle_t queue, void* item) { return receive(queue, item, 0, false); }
+
+BaseType_t xQueueOverwrite(QueueHandle_t handle, const void* item)
+{
+    HostQueue* queue = (HostQueue*) handle;
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->items.clear();
+    queue->items.push_back(std::vector<uint8_t>((const uint8_t*) item, (const uint8_t*) item + queue->itemSize));
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xQueueOverwriteFromISR(QueueHandle_t queue, const void* item, BaseType_t*)
+{
+    return xQueueOverwrite(queue, item);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t handle)
+{
+    HostQueue* queue = (HostQueue*) handle;
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->items.size();
+}
+
+UBaseType_t uxQueueMessagesWaitingFromISR(QueueHandle_t queue)
+{
+    return uxQueueMessagesWaiting(queue);
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t handle)
+{
+    HostQueue* queue = (HostQueue*) handle;
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->length - queue->items.size();
+}
+
+//-----------------------------------------------------------------------------------------------------||
+//---------- Mutexes ----------------------------------------------------------------------------------||
+
+struct HostMutex
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool taken = false;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return new HostMutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t handle, TickType_t ticks)
+{
+    HostMutex* mutex = (HostMutex*) handle;
+    std::unique_lock<std::mutex> lock(mutex->mutex);
+    if (!waitUntil(lock, mutex->changed, ticks, [mutex] { return !mutex->taken; })) return pdFALSE;
+    mutex->taken = true;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t handle)
+{
+    HostMutex* mutex = (HostMutex*) handle;
+    std::lock_guard<std::mutex> lock(mutex->mutex);
+    mutex->taken = false;
+    mutex->changed.notify_one();
+    return pdTRUE;
+}
+
+//-----------------------------------------------------------------------------------------------------||
+//---------- Event groups -----------------------------------------------------------------------------||
+
+struct HostEventGroup
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    EventBits_t bits = 0;
+};
+
+EventGroupHandle_t xEventGroupCreate()
+{
+    return new HostEventGroup;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t handle, EventBits_t bits)
+{
+    HostEventGroup* group = (HostEventGroup*) handle;
+    std::lock_guard<std::mutex> lock(group->mutex);
+    group->bits |= bits;
+    group->changed.notify_all();
+    return group->bits;
+}
+
+EventBits_t xEventGroupSetBitsFromISR(EventGroupHandle_t group, EventBits_t bits, BaseType_t*)
+{
+    xEventGroupSetBits(group, bits);
+    return pdPASS;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t handle, EventBits_t bits)
+{
+    HostEventGroup* group = (HostEventGroup*) handle;
+    std::lock_guard<std::mutex> lock(group->mutex);
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    return before;
+}
+
+EventBits_t xEventGroupClearBitsFromISR(EventGroupHandle_t group, EventBits_t bits)
+{
+    return xEventGroupClearBits(group, bits);
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t handle)
+{
+    HostEventGroup* group = (HostEventGroup*) handle;
+    std::lock_guard<std::mutex> lock(group->mutex);
+    return group->bits;
+}
+
+EventBits_t xEventGroupGetBitsFromISR(EventGroupHandle_t group)
+{
+    return xEventGroupGetBits(group);
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t handle, EventBits_t bits, BaseType_t clear,
+                                BaseType_t all, TickType_t ticks)
+{
+    HostEventGroup* group = (HostEventGroup*) handle;
+    std::unique_lock<std::mutex> lock(group->mutex);
+    bool met = waitUntil(lock, group->changed, ticks, [group, bits, all] {
+        return all ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+    });
+
+    EventBits_t seen = group->bits;
+    if (met && clear) group->bits &= ~bits;
+    return seen;
+}
+
+//-----------------------------------------------------------------------------------------------------||
+//---------- Tasks ------------------------------------------------------------------------------------||
+
+struct HostTask
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    uint32_t notifications = 0;
+    UBaseType_t priority = 1;
+};
+
+static thread_local HostTask self;
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return &self;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle)
+{
+    HostTask* task = (HostTask*) handle;
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->notifications++;
+    task->changed.notify_all();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t*)
+{
+    xTaskNotifyGive(task);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(self.mutex);
+    waitUntil(lock, self.changed, ticks, [] { return self.notifications > 0; });
+
+    uint32_t count = self.notifications;
+    if (clear) self.notifications = 0;
+    else if (count) self.notifications--;
+    return count;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+    return task ? ((HostTask*) task)->priority : self.priority;
+}
+
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority)
+{
+    (task ? (HostTask*) task : &self)->priority = priority;
+}
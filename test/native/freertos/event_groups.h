@@ -0,0 +1,11 @@
+/**
+ * @file event_groups.h
+ * @brief Host stand-in for the FreeRTOS event group header, declared in Arduino.h
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
@@ -0,0 +1,56 @@
+/**
+ * @file hostTest.h
+ * @brief The few checks the host tests need
+ * @details A failed CHECK prints where it was and carries on, the test's
+ *          main() returns hostTestResult() so ctest sees the failure
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+static int hostTestFailures = 0; ///< Number of failed checks so far
+
+/// Check a condition, print it and where it is if it does not hold
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            hostTestFailures++; \
+        } \
+    } while (0)
+
+/// Check two integers are equal, print both if they are not
+#define CHECK_EQUAL(expected, actual) \
+    do \
+    { \
+        long long e_ = (long long) (expected); \
+        long long a_ = (long long) (actual); \
+        if (e_ != a_) \
+        { \
+            fprintf(stderr, "%s:%d: CHECK_EQUAL(%s, %s) failed, %lld != %lld\n", \
+                __FILE__, __LINE__, #expected, #actual, e_, a_); \
+            hostTestFailures++; \
+        } \
+    } while (0)
+
+/**
+ * @brief What main() returns
+ *
+ * @return 0 if every check held, 1 if any failed
+ */
+static inline int hostTestResult(void)
+{
+    fprintf(stderr, hostTestFailures ? "%d check(s) failed\n" : "All checks passed\n", hostTestFailures);
+    return hostTestFailures ? 1 : 0;
+}
+
+#endif //HOST_TEST_H
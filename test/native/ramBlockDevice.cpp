@@ -0,0 +1,85 @@
+/**
+ * @file ramBlockDevice.cpp
+ * @brief A RAM-backed stand-in for the SD card that counts what is done to it
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include "ramBlockDevice.h"
+
+RamBlockDevice :: RamBlockDevice(uint32_t sectors)
+    : data((size_t) sectors * RAM_SECTOR_SIZE), writes(sectors)
+{
+}
+
+bool RamBlockDevice :: readSector(uint32_t sector, uint8_t* buffer)
+{
+    return readSectors(sector, buffer, 1);
+}
+
+bool RamBlockDevice :: readSectors(uint32_t sector, uint8_t* buffer, size_t count)
+{
+    if (sector + count > writes.size()) return false;
+
+    memcpy(buffer, &data[(size_t) sector * RAM_SECTOR_SIZE], count * RAM_SECTOR_SIZE);
+    stats.readCommands++;
+    stats.sectorsRead += count;
+    return true;
+}
+
+bool RamBlockDevice :: writeSector(uint32_t sector, const uint8_t* buffer)
+{
+    return writeSectors(sector, buffer, 1);
+}
+
+bool RamBlockDevice :: writeSectors(uint32_t sector, const uint8_t* buffer, size_t count)
+{
+    if (sector + count > writes.size()) return false;
+
+    memcpy(&data[(size_t) sector * RAM_SECTOR_SIZE], buffer, count * RAM_SECTOR_SIZE);
+    for (size_t i = 0; i < count; i++) writes[sector + i]++;
+    stats.writeCommands++;
+    stats.sectorsWritten += count;
+
+    if (writeDelayUs) std::this_thread::sleep_for(std::chrono::microseconds(writeDelayUs));
+    return true;
+}
+
+bool RamBlockDevice :: syncDevice()
+{
+    stats.syncs++;
+    return true;
+}
+
+uint32_t RamBlockDevice :: sectorCount()
+{
+    return writes.size();
+}
+
+void RamBlockDevice :: erase()
+{
+    memset(data.data(), 0, data.size());
+    memset(writes.data(), 0, writes.size() * sizeof(writes[0]));
+    resetStats();
+}
+
+void RamBlockDevice :: resetStats()
+{
+    stats = RamBlockStats();
+}
+
+const RamBlockStats& RamBlockDevice :: getStats()
+{
+    return stats;
+}
+
+uint32_t RamBlockDevice :: writeCount(uint32_t sector)
+{
+    return sector < writes.size() ? writes[sector] : 0;
+}
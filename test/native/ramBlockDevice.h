@@ -0,0 +1,71 @@
+/**
+ * @file ramBlockDevice.h
+ * @brief A RAM-backed stand-in for the SD card that counts what is done to it
+ * @details Sectors are 512 bytes, like the card's. Every command is counted,
+ *          and every sector keeps the number of times it was written, so a
+ *          test can see the read-modify-writes and metadata updates the file
+ *          system sends to the card, not just the bytes a file grew by.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef RAM_BLOCK_DEVICE_H
+#define RAM_BLOCK_DEVICE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#define RAM_SECTOR_SIZE 512 ///< Bytes per sector
+#define RAM_CARD_SECTORS 32768 ///< Sectors on the card, 16 MiB
+
+/**
+ * @brief Counters of the commands sent to the card
+ *
+ */
+struct RamBlockStats
+{
+    uint32_t readCommands; ///< Number of read commands
+    uint32_t sectorsRead; ///< Sectors read by them
+    uint32_t writeCommands; ///< Number of write commands
+    uint32_t sectorsWritten; ///< Sectors written by them
+    uint32_t syncs; ///< Number of device syncs
+};
+
+class RamBlockDevice
+{
+    protected:
+        std::vector<uint8_t> data; ///< Every sector, back to back
+        std::vector<uint32_t> writes; ///< Times each sector was written
+        RamBlockStats stats = {}; ///< Commands since the last erase()
+
+    public:
+        uint32_t writeDelayUs = 0; ///< Extra time every write command takes, to play a slow card
+
+        RamBlockDevice(uint32_t sectors = RAM_CARD_SECTORS); ///< A constructor for a blank card
+
+        bool readSector(uint32_t sector, uint8_t* buffer); ///< A method to read one sector
+
+        bool readSectors(uint32_t sector, uint8_t* buffer, size_t count); ///< A method to read consecutive sectors
+
+        bool writeSector(uint32_t sector, const uint8_t* buffer); ///< A method to write one sector
+
+        bool writeSectors(uint32_t sector, const uint8_t* buffer, size_t count); ///< A method to write consecutive sectors
+
+        bool syncDevice(void); ///< A method to wait for the card to finish
+
+        uint32_t sectorCount(void); ///< A method to get the size of the card in sectors
+
+        void erase(void); ///< A method to zero the card and its counters
+
+        void resetStats(void); ///< A method to zero the counters only
+
+        const RamBlockStats& getStats(void); ///< A method to get the counters
+
+        uint32_t writeCount(uint32_t sector); ///< A method to get the times one sector was written
+};
+
+#endif //RAM_BLOCK_DEVICE_H
@@ -0,0 +1,586 @@
+/**
+ * @file sdFat.cpp
+ * @brief Host stand-in for SdFat's exFAT volume and file classes, on a
+ *        RamBlockDevice
+ * @details Sector 0 stands for the allocation bitmap and sector 1 for the
+ *          directory entries of every file, the rest hold file data. Only the
+ *          number of times they are written matters, not what is in them.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <SdFat.h>
+#include <strings.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define BITMAP_SECTOR 0 ///< Written when clusters are allocated or freed
+#define DIRECTORY_SECTOR 1 ///< Written when a directory entry changes
+#define FIRST_DATA_SECTOR 2 ///< First sector handed to files
+#define NO_SECTOR 0xFFFFFFFF ///< The cache holds nothing
+
+/**
+ * @brief One directory entry set and whatever it points to
+ *
+ */
+struct RamSlot
+{
+    std::shared_ptr<RamNode> node; ///< NULL once removed, the entry set stays where it was
+    uint32_t bytes; ///< Size of the entry set
+};
+
+struct RamNode
+{
+    std::string name;
+    bool directory = false;
+    uint64_t size = 0; ///< Bytes of data, for a file
+    std::vector<uint32_t> sectors; ///< Data sectors in file order, including preallocated ones
+    std::vector<RamSlot> slots; ///< Entries of a directory in the order they were made
+    bool entryDirty = false; ///< The directory entry has to be written on the next sync
+};
+
+/**
+ * @brief The one mounted volume
+ *
+ */
+static struct RamVolume
+{
+    RamBlockDevice card;
+    std::shared_ptr<RamNode> root;
+    std::vector<bool> used; ///< Sectors handed out
+    bool bitmapDirty = false;
+    uint32_t cacheSector = NO_SECTOR;
+    bool cacheDirty = false;
+    uint8_t cache[RAM_SECTOR_SIZE];
+
+    void reset()
+    {
+        card.erase();
+        root = std::make_shared<RamNode>();
+        root->directory = true;
+        used.assign(card.sectorCount(), false);
+        used[BITMAP_SECTOR] = true;
+        used[DIRECTORY_SECTOR] = true;
+        bitmapDirty = false;
+        cacheSector = NO_SECTOR;
+        cacheDirty = false;
+    }
+
+    bool flushCache()
+    {
+        if (cacheDirty && !card.writeSector(cacheSector, cache)) return false;
+        cacheDirty = false;
+        return true;
+    }
+
+    /**
+     * @brief Bring a sector into the cache
+     *
+     * @param sector The sector
+     * @param fill Whether what is on the card matters, a sector about to be
+     *        written from its start past the end of a file does not
+     * @return The cached sector, NULL on a card error
+     */
+    uint8_t* fetch(uint32_t sector, bool fill)
+    {
+        if (cacheSector != sector)
+        {
+            if (!flushCache()) return NULL;
+            cacheSector = NO_SECTOR;
+            if (fill)
+            {
+                if (!card.readSector(sector, cache)) return NULL;
+            }
+            else
+            {
+                memset(cache, 0, sizeof(cache));
+            }
+            cacheSector = sector;
+        }
+        return cache;
+    }
+
+    /// Drop a cached sector that is about to be overwritten or freed
+    void forget(uint32_t first, uint32_t count)
+    {
+        if (cacheSector != NO_SECTOR && cacheSector >= first && cacheSector < first + count)
+        {
+            cacheSector = NO_SECTOR;
+            cacheDirty = false;
+        }
+    }
+
+    /// Find a run of free sectors, preferring the one right after near
+    uint32_t allocate(uint32_t count, uint32_t near)
+    {
+        if (near != NO_SECTOR && near + count <= used.size())
+        {
+            bool free = true;
+            for (uint32_t i = 0; i < count && free; i++) free = !used[near + i];
+            if (free) return near;
+        }
+
+        uint32_t run = 0;
+        for (uint32_t sector = FIRST_DATA_SECTOR; sector < used.size(); sector++)
+        {
+            run = used[sector] ? 0 : run + 1;
+            if (run == count) return sector + 1 - count;
+        }
+        return NO_SECTOR;
+    }
+
+    bool grow(RamNode& node, size_t sectors, bool contiguous)
+    {
+        while (node.sectors.size() < sectors)
+        {
+            uint32_t near = node.sectors.empty() ? NO_SECTOR : node.sectors.back() + 1;
+            uint32_t count = contiguous ? sectors - node.sectors.size() : 1;
+            uint32_t first = allocate(count, near);
+            if (first == NO_SECTOR) return false;
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                used[first + i] = true;
+                node.sectors.push_back(first + i);
+            }
+            bitmapDirty = true;
+        }
+        return true;
+    }
+
+    void shrink(RamNode& node, size_t sectors)
+    {
+        while (node.sectors.size() > sectors)
+        {
+            uint32_t sector = node.sectors.back();
+            node.sectors.pop_back();
+            forget(sector, 1);
+            used[sector] = false;
+            bitmapDirty = true;
+        }
+    }
+
+    /// Write the metadata a sync settles
+    bool syncEntry(RamNode& node)
+    {
+        if (!flushCache()) return false;
+        if (node.entryDirty)
+        {
+            uint8_t sector[RAM_SECTOR_SIZE] = {};
+            if (!card.writeSector(DIRECTORY_SECTOR, sector)) return false;
+            node.entryDirty = false;
+        }
+        if (bitmapDirty)
+        {
+            uint8_t sector[RAM_SECTOR_SIZE] = {};
+            if (!card.writeSector(BITMAP_SECTOR, sector)) return false;
+            bitmapDirty = false;
+        }
+        return card.syncDevice();
+    }
+} volume;
+
+/**
+ * @brief Split a path into its parent directory and last name
+ *
+ * @param path An absolute path, or one relative to the root
+ * @param name Set to the last name in the path
+ * @return The parent directory, NULL if it does not exist
+ */
+static std::shared_ptr<RamNode> lookupParent(const char* path, std::string& name)
+{
+    if (!volume.root) volume.reset();
+
+    std::shared_ptr<RamNode> dir = volume.root;
+    std::string rest(path);
+    size_t start = rest.find_first_not_of('/');
+    name.clear();
+
+    while (start != std::string::npos)
+    {
+        size_t end = rest.find('/', start);
+        std::string part = rest.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        start = (end == std::string::npos) ? end : rest.find_first_not_of('/', end);
+        if (start == std::string::npos)
+        {
+            name = part;
+            break;
+        }
+
+        std::shared_ptr<RamNode> next;
+        for (RamSlot& slot : dir->slots)
+        {
+            if (slot.node && strcasecmp(slot.node->name.c_str(), part.c_str()) == 0) next = slot.node;
+        }
+        if (!next || !next->directory) return NULL;
+        dir = next;
+    }
+    return dir;
+}
+
+static std::shared_ptr<RamNode> lookup(const char* path)
+{
+    std::string name;
+    std::shared_ptr<RamNode> dir = lookupParent(path, name);
+    if (!dir) return NULL;
+    if (name.empty()) return dir;
+
+    for (RamSlot& slot : dir->slots)
+    {
+        if (slot.node && strcasecmp(slot.node->name.c_str(), name.c_str()) == 0) return slot.node;
+    }
+    return NULL;
+}
+
+static std::shared_ptr<RamNode> create(const char* path, bool directory)
+{
+    std::string name;
+    std::shared_ptr<RamNode> dir = lookupParent(path, name);
+    if (!dir || name.empty()) return NULL;
+
+    std::shared_ptr<RamNode> node = std::make_shared<RamNode>();
+    node->name = name;
+    node->directory = directory;
+    node->entryDirty = true;
+
+    // A file entry, a stream extension entry and a name entry per 15 characters
+    RamSlot slot = {node, (uint32_t) (32 * (2 + (name.size() + 14) / 15))};
+    dir->slots.push_back(slot);
+
+    uint8_t sector[RAM_SECTOR_SIZE] = {};
+    volume.card.writeSector(DIRECTORY_SECTOR, sector);
+    node->entryDirty = false;
+    return node;
+}
+
+//-----------------------------------------------------------------------------------------------------||
+//---------- ExFile -----------------------------------------------------------------------------------||
+
+bool ExFile :: writable() const
+{
+    return (flags & O_ACCMODE) != O_RDONLY;
+}
+
+bool ExFile :: open(const char* path, oflag_t oflag)
+{
+    close();
+
+    std::shared_ptr<RamNode> found = lookup(path);
+    if (found && (oflag & O_CREAT) && (oflag & O_EXCL)) return false;
+    if (!found)
+    {
+        if (!(oflag & O_CREAT)) return false;
+        found = create(path, false);
+        if (!found) return false;
+    }
+    if (found->directory && (oflag & O_ACCMODE) != O_RDONLY) return false;
+
+    node = found;
+    flags = oflag;
+    position = 0;
+
+    if (!found->directory && (oflag & O_TRUNC) && writable())
+    {
+        volume.shrink(*node, 0);
+        node->size = 0;
+        node->entryDirty = true;
+    }
+    // Like SdFat, O_APPEND moves to the end at every write, not here
+    return true;
+}
+
+bool ExFile :: openNext(ExFile* dir, oflag_t oflag)
+{
+    close();
+    if (!dir || !dir->isDirectory()) return false;
+
+    uint64_t offset = 0;
+    for (RamSlot& slot : dir->node->slots)
+    {
+        uint64_t next = offset + slot.bytes;
+        if (offset >= dir->position && slot.node)
+        {
+            dir->position = next;
+            node = slot.node;
+            flags = oflag;
+            position = 0;
+            return true;
+        }
+        offset = next;
+    }
+    dir->position = offset;
+    return false;
+}
+
+bool ExFile :: close()
+{
+    bool ok = true;
+    if (node && writable()) ok = sync();
+    node.reset();
+    position = 0;
+    return ok;
+}
+
+bool ExFile :: remove()
+{
+    if (!node || node->directory || !writable()) return false;
+
+    volume.shrink(*node, 0);
+    std::function<bool(RamNode&)> unlink = [&](RamNode& dir) {
+        for (RamSlot& slot : dir.slots)
+        {
+            if (slot.node == node)
+            {
+                slot.node.reset();
+                return true;
+            }
+            if (slot.node && slot.node->directory && unlink(*slot.node)) return true;
+        }
+        return false;
+    };
+    unlink(*volume.root);
+    node.reset();
+    return volume.syncEntry(*volume.root);
+}
+
+bool ExFile :: isDirectory() const
+{
+    return node && node->directory;
+}
+
+size_t ExFile :: getName(char* name, size_t size)
+{
+    if (!node || node->name.size() + 1 > size) return 0;
+    memcpy(name, node->name.c_str(), node->name.size() + 1);
+    return node->name.size();
+}
+
+uint64_t ExFile :: fileSize() const
+{
+    return (node && !node->directory) ? node->size : 0;
+}
+
+bool ExFile :: seekSet(uint64_t pos)
+{
+    if (!node) return false;
+    if (!node->directory && pos > node->size) return false;
+    position = pos;
+    return true;
+}
+
+int ExFile :: available() const
+{
+    uint64_t left = fileSize() > position ? fileSize() - position : 0;
+    return left > 0x7FFFFFFF ? 0x7FFFFFFF : (int) left;
+}
+
+int ExFile :: read()
+{
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+}
+
+int ExFile :: read(void* buffer, size_t count)
+{
+    if (!node || node->directory) return -1;
+
+    uint8_t* dst = (uint8_t*) buffer;
+    size_t done = 0;
+    while (done < count && position < node->size)
+    {
+        uint32_t offset = position % RAM_SECTOR_SIZE;
+        uint32_t sector = node->sectors[position / RAM_SECTOR_SIZE];
+        size_t n = RAM_SECTOR_SIZE - offset;
+        if (n > count - done) n = count - done;
+        if (n > node->size - position) n = node->size - position;
+
+        if (n == RAM_SECTOR_SIZE && volume.cacheSector != sector)
+        {
+            // Whole sectors go straight into the caller's buffer
+            if (!volume.card.readSector(sector, dst + done)) return -1;
+        }
+        else
+        {
+            uint8_t* cached = volume.fetch(sector, true);
+            if (!cached) return -1;
+            memcpy(dst + done, cached + offset, n);
+        }
+        done += n;
+        position += n;
+    }
+    return done;
+}
+
+int ExFile :: fgets(char* str, int num, char* delim)
+{
+    int length = 0;
+    while (length < num - 1)
+    {
+        int c = read();
+        if (c < 0) break;
+        str[length++] = c;
+        if (delim ? strchr(delim, c) != NULL : c == '\n') break;
+    }
+    str[length] = '\0';
+    return length;
+}
+
+size_t ExFile :: write(const void* buffer, size_t count)
+{
+    if (!node || node->directory || !writable()) return 0;
+    if (flags & O_APPEND) position = node->size;
+
+    const uint8_t* src = (const uint8_t*) buffer;
+    size_t done = 0;
+    while (done < count)
+    {
+        size_t index = position / RAM_SECTOR_SIZE;
+        uint32_t offset = position % RAM_SECTOR_SIZE;
+        size_t n;
+
+        if (offset == 0 && count - done >= RAM_SECTOR_SIZE)
+        {
+            // Whole sectors go straight to the card, as many as are contiguous
+            size_t whole = (count - done) / RAM_SECTOR_SIZE;
+            if (!volume.grow(*node, index + whole, false)) break;
+
+            uint32_t first = node->sectors[index];
+            size_t run = 1;
+            while (run < whole && node->sectors[index + run] == first + run) run++;
+
+            volume.forget(first, run);
+            if (!volume.card.writeSectors(first, src + done, run)) break;
+            n = run * RAM_SECTOR_SIZE;
+        }
+        else
+        {
+            if (!volume.grow(*node, index + 1, false)) break;
+
+            // A sector started past the end of the file has nothing worth reading
+            bool fill = !(offset == 0 && position >= node->size);
+            uint8_t* cached = volume.fetch(node->sectors[index], fill);
+            if (!cached) break;
+
+            n = RAM_SECTOR_SIZE - offset;
+            if (n > count - done) n = count - done;
+            memcpy(cached + offset, src + done, n);
+            volume.cacheDirty = true;
+        }
+
+        done += n;
+        position += n;
+        if (position > node->size)
+        {
+            node->size = position;
+            node->entryDirty = true;
+        }
+    }
+    return done;
+}
+
+bool ExFile :: sync()
+{
+    if (!node) return false;
+    return volume.syncEntry(*node);
+}
+
+bool ExFile :: preAllocate(uint64_t length)
+{
+    if (!node || node->directory || !writable() || !node->sectors.empty()) return false;
+    if (!volume.grow(*node, (length + RAM_SECTOR_SIZE - 1) / RAM_SECTOR_SIZE, true))
+    {
+        volume.shrink(*node, 0);
+        return false;
+    }
+    node->entryDirty = true;
+    return true;
+}
+
+bool ExFile :: truncate()
+{
+    if (!node || node->directory || !writable()) return false;
+
+    volume.shrink(*node, (position + RAM_SECTOR_SIZE - 1) / RAM_SECTOR_SIZE);
+    if (node->size != position)
+    {
+        node->size = position;
+        node->entryDirty = true;
+    }
+    return true;
+}
+
+bool ExFile :: truncate(uint64_t length)
+{
+    return seekSet(length) && truncate();
+}
+
+uint32_t ExFile :: firstSector() const
+{
+    if (!node || node->sectors.empty()) return 0;
+    for (size_t i = 1; i < node->sectors.size(); i++)
+    {
+        if (node->sectors[i] != node->sectors[0] + i) return 0;
+    }
+    return node->sectors[0];
+}
+
+//-----------------------------------------------------------------------------------------------------||
+//---------- SdFat ------------------------------------------------------------------------------------||
+
+bool SdFat :: begin(int csPin, uint32_t maxSck)
+{
+    if (!volume.root) volume.reset();
+    return true;
+}
+
+bool SdFat :: format()
+{
+    volume.reset();
+    return true;
+}
+
+ExFile SdFat :: open(const char* path, oflag_t oflag)
+{
+    ExFile file;
+    file.open(path, oflag);
+    return file;
+}
+
+bool SdFat :: exists(const char* path)
+{
+    return lookup(path) != NULL;
+}
+
+bool SdFat :: mkdir(const char* path, bool pFlag)
+{
+    std::shared_ptr<RamNode> found = lookup(path);
+    if (found) return found->directory;
+
+    std::string name;
+    if (!lookupParent(path, name))
+    {
+        if (!pFlag) return false;
+
+        // Make the parents first
+        std::string parent(path);
+        parent = parent.substr(0, parent.find_last_of('/'));
+        if (parent.empty() || !mkdir(parent.c_str(), true)) return false;
+    }
+    return create(path, true) != NULL;
+}
+
+bool SdFat :: remove(const char* path)
+{
+    ExFile file;
+    return file.open(path, O_RDWR) && file.remove();
+}
+
+RamBlockDevice* SdFat :: card()
+{
+    if (!volume.root) volume.reset();
+    return &volume.card;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file sharedData.cpp
+ * @brief The shared variables main.cpp defines on the board, for the host tests
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include "setup.h"
+#include "sharedData.h"
+
+// Non-volatile Variables
+RTC_DATA_ATTR uint32_t wakeCounter = 0;
+RTC_DATA_ATTR uint32_t lastFixedUTX = 0;
+RTC_DATA_ATTR float prevBatteryPercent = 0;
+RTC_DATA_ATTR bool internal = false;
+RTC_DATA_ATTR int8_t utc_offset = 0;
+
+// Watchdog Checks
+EventFlags<WatchCheck> watchChecks("Watch Checks");
+
+// Flags
+EventFlags<TaskFlag> taskFlags("Task Flags");
+Share<bool> gnssPowerSave("GNSS Power Save");
+Share<int8_t> inLongSurvey("inLongSurvey");
+
+// Shares from GPS Clock
+SnapshotShare<GNSSFix> gnssFix("GNSS Fix");
+Share<uint32_t> unixTime("Unix Time");
+SnapshotShare<Timestamp> displayTime("Display Time");
+Share<uint64_t> sleepTime("Sleep Time");
+
+// Shares from sensors
+SnapshotShare<SampleRecord> lastSample("Last Sample");
+Share<float> temperature("Temperature");
+Share<float> humidity("Humidity");
+Share<int> radarDistance("Radar Distance");
+
+// Shares from GNSS
+Share<int> numSFRBX("Number of SFRBX msgs");
+Share<int> numRAWX("Number of RAWX msgs");
+GNSSBufferPool gnssBuffers(GNSS_BUFFER_SLOTS, sdWriteSize, "GNSS Buffers");
+
+// Requests to the SD task
+Queue<SDRequest> sdRequests(SD_QUEUE_SIZE, "SD Requests", pdMS_TO_TICKS(SD_QUEUE_WAIT));
+
+// BLE events for the Bluetooth task
+Queue<uint8_t> bleEvents(BLE_EVENT_QUEUE_SIZE, "BLE Events");
+
+// Duty Cycle
+Share<float> batteryPercent("Battery Percent");
+Share<float> battery("Battery Voltage");
+Share<uint32_t> READ_TIME("Read Time");
+Share<uint16_t> MINUTE_ALLIGN("Minute Allign");
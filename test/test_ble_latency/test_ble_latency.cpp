@@ -0,0 +1,132 @@
+/**
+ * @file test_ble_latency.cpp
+ * @brief How long a central waits for the Bluetooth task, and what waiting costs
+ * @details Runs the real task for four simulated hours. Centrals turn up 2 to
+ *          20 s apart and scan continuously, the link comes up at the first
+ *          advertising event after that and drops 3 s after the task notices
+ *          it. Measures the time from a central starting to connect to
+ *          BLE.central() returning it, and how often the task wakes while
+ *          advertising and while connected.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include <ArduinoBLE.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "hostTest.h"
+#include "setup.h"
+#include "sharedData.h"
+#include "waterSenseTasks/taskBluetooth/taskBluetooth.h"
+
+static const uint64_t RUN_MS = 4ULL * 3600 * 1000; ///< Simulated time the task runs for
+static const uint64_t LINK_MS = 3000; ///< How long a central stays once it is noticed
+
+/// Thrown from step() once RUN_MS is up
+struct Stop {};
+
+static std::mt19937 arrivals(1);
+static uint64_t previousMs = 0; ///< When step() last ran
+static uint64_t attemptAt = 3000; ///< When the next central starts to connect
+static bool waiting = true; ///< A central is scanning and not connected yet
+static bool noticed = false; ///< The task has seen the current connection
+static std::vector<uint64_t> latencies; ///< ms from starting to connect to being noticed
+static uint64_t wakeupsAdvertising = 0;
+static uint64_t wakeupsConnected = 0;
+static uint64_t msAdvertising = 0;
+static uint64_t msConnected = 0;
+
+/// Called every time the task blocks and the clock moves on
+static void step(uint64_t now)
+{
+    // Whatever the task was doing up to now, it wakes once here
+    uint64_t elapsed = now - previousMs;
+    previousMs = now;
+    if (hostCentral.linked)
+    {
+        wakeupsConnected++;
+        msConnected += elapsed;
+    }
+    else
+    {
+        wakeupsAdvertising++;
+        msAdvertising += elapsed;
+    }
+
+    // The SD task, nothing is written
+    SDRequest request;
+    while (xQueueReceive(sdRequests.get_handle(), &request, 0) == pdTRUE) {}
+
+    // The link comes up on the first advertising event after the central starts scanning
+    if (waiting && hostCentral.advertising && now >= attemptAt)
+    {
+        double interval = hostCentral.advertisingInterval * 0.625;
+        uint64_t from = std::max<uint64_t>(attemptAt, hostCentral.advertisingSince);
+        uint64_t event = hostCentral.advertisingSince + (uint64_t) (std::ceil((from - hostCentral.advertisingSince) / interval) * interval);
+        if (event <= now)
+        {
+            waiting = false;
+            hostCentral.connect();
+        }
+    }
+
+    if (hostCentral.linked && hostCentral.seenAt && !noticed)
+    {
+        noticed = true;
+        latencies.push_back(hostCentral.seenAt - attemptAt);
+    }
+    if (noticed && now >= hostCentral.seenAt + LINK_MS)
+    {
+        noticed = false;
+        hostCentral.disconnect();
+        attemptAt = now + 2000 + arrivals() % 18000;
+        waiting = true;
+    }
+
+    if (now >= RUN_MS) throw Stop();
+}
+
+int main()
+{
+    taskFlags.set(FLAG_WAKE_READY);
+    hostSimulateTime(step);
+    try
+    {
+        taskBluetooth(NULL);
+    }
+    catch (Stop&)
+    {
+    }
+    hostSimulateTime(NULL);
+
+    std::sort(latencies.begin(), latencies.end());
+    double sum = 0;
+    for (uint64_t latency : latencies) sum += latency;
+    double mean = sum / latencies.size();
+    uint64_t p95 = latencies[latencies.size() * 95 / 100];
+    double idleRate = wakeupsAdvertising * 1000.0 / msAdvertising;
+    double connectedRate = wakeupsConnected * 1000.0 / msConnected;
+
+    printf("%zu connections, ms to be noticed: mean %.0f, median %llu, p95 %llu, max %llu\n", latencies.size(), mean,
+        (unsigned long long) latencies[latencies.size() / 2], (unsigned long long) p95, (unsigned long long) latencies.back());
+    printf("Wakeups per second: %.2f advertising, %.2f connected\n", idleRate, connectedRate);
+
+    // One advertising interval to connect and one poll period to notice, at most
+    CHECK(latencies.size() > 500);
+    CHECK(latencies.back() <= 2 * BLE_IDLE_PERIOD);
+    CHECK(mean < BLE_IDLE_PERIOD);
+
+    // No more often than the advertising interval while there is nothing to do
+    CHECK(BLE_IDLE_PERIOD * 8 >= BLE_ADVERT_INTERVAL * 5);
+    CHECK(idleRate <= 1000.0 / BLE_IDLE_PERIOD + 0.01);
+    CHECK(idleRate < 1.0);
+    CHECK(connectedRate <= 1000.0 / BLE_CONNECTED_PERIOD + 0.5);
+
+    return hostTestResult();
+}
@@ -0,0 +1,212 @@
+/**
+ * @file test_bluetooth_files.cpp
+ * @brief The Bluetooth file manager reading what SD_Data wrote, on the RAM card
+ * @details Files are streamed with their CRCs, the file being appended to is
+ *          refused, record queries find their samples through the catalog and
+ *          directory pages carry on from their cursors
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include <vector>
+#include "hostTest.h"
+#include "setup.h"
+#include "sharedData.h"
+#include "waterSenseLibs/sdData/sdData.h"
+#include "waterSenseLibs/sdData/sdBus.h"
+#include "waterSenseLibs/bluetooth/bluetooth.h"
+#include "waterSenseLibs/crc32/crc32.h"
+
+static const uint32_t START = 0x60000000; ///< Time of the first sample
+static const uint32_t PER_FILE = 100; ///< Samples in each closed data file
+static const uint32_t FILES = 4; ///< Data files written, the last one is left open
+
+/// The whole of a file, read without the file manager
+static std::vector<uint8_t> readFile(const String& path)
+{
+    std::vector<uint8_t> bytes;
+    ExFile file = SD.open(path.c_str(), O_RDONLY);
+    int c;
+    while ((c = file.read()) >= 0) bytes.push_back(c);
+    file.close();
+    return bytes;
+}
+
+/// Everything readChunk() returns for what is loaded, in chunks of chunkSize
+static std::vector<uint8_t> readAll(size_t chunkSize)
+{
+    std::vector<uint8_t> bytes;
+    uint8_t chunk[BT_MAX_CHUNK_SIZE];
+    size_t length;
+    while ((length = bluetoothFileManager.readChunk(chunk, chunkSize)) > 0)
+    {
+        bytes.insert(bytes.end(), chunk, chunk + length);
+    }
+    return bytes;
+}
+
+/**
+ * @brief A file is streamed as it is, with one CRC per sector
+ *
+ */
+static void testLoadFile(const std::vector<String>& paths)
+{
+    std::vector<uint8_t> expected = readFile(paths[0]);
+    CHECK(expected.size() > BT_BLOCK_SIZE);
+
+    CHECK(bluetoothFileManager.loadFile(paths[0]));
+    CHECK_EQUAL(expected.size(), bluetoothFileManager.getFileSize());
+
+    std::vector<uint8_t> sent;
+    uint8_t chunk[BT_CHUNK_SIZE];
+    size_t length;
+    uint32_t blocks = 0;
+    BlockCrc blockCrc;
+    while ((length = bluetoothFileManager.readChunk(chunk, sizeof(chunk))) > 0)
+    {
+        sent.insert(sent.end(), chunk, chunk + length);
+        while (bluetoothFileManager.peekBlockCrc(blockCrc))
+        {
+            CHECK_EQUAL(blocks * BT_BLOCK_SIZE, blockCrc.offset);
+            CHECK_EQUAL(crc32Update(0, &expected[blockCrc.offset], blockCrc.length), blockCrc.crc);
+
+            // Still there until it is popped
+            BlockCrc again;
+            CHECK(bluetoothFileManager.peekBlockCrc(again));
+            CHECK_EQUAL(blockCrc.offset, again.offset);
+            bluetoothFileManager.popBlockCrc();
+            blocks++;
+        }
+    }
+    CHECK(sent == expected);
+    CHECK_EQUAL((expected.size() + BT_BLOCK_SIZE - 1) / BT_BLOCK_SIZE, blocks);
+    CHECK_EQUAL(crc32Update(0, expected.data(), expected.size()), bluetoothFileManager.getCurrentChecksum());
+
+    // A range from the middle of a sector
+    CHECK(bluetoothFileManager.loadFile(paths[1], 700, 300));
+    std::vector<uint8_t> whole = readFile(paths[1]);
+    std::vector<uint8_t> range = readAll(BT_CHUNK_SIZE);
+    CHECK(range == std::vector<uint8_t>(whole.begin() + 700, whole.begin() + 1000));
+    bluetoothFileManager.clearFile();
+}
+
+/**
+ * @brief The file the SD task is appending to is left alone
+ *
+ */
+static void testBusyFile(const String& openPath)
+{
+    CHECK(bluetoothFileManager.isFileBusy(openPath));
+    CHECK(!bluetoothFileManager.loadFile(openPath));
+
+    String lower = openPath;
+    for (unsigned int i = 0; i < lower.length(); i++) lower = lower.substring(0, i) + String((char) tolower(lower[i])) + lower.substring(i + 1);
+    CHECK(bluetoothFileManager.isFileBusy(lower));
+
+    // The catalog is rewritten in place while the SD task has it open
+    CHECK(bluetoothFileManager.isFileBusy(CATALOG_PATH));
+    CHECK(!bluetoothFileManager.loadFile(CATALOG_PATH));
+}
+
+/**
+ * @brief Record queries return the samples of closed files in the range, oldest first
+ *
+ */
+static void testQueries(void)
+{
+    const uint32_t closed = (FILES - 1) * PER_FILE;
+
+    CHECK(bluetoothFileManager.loadSince(START + 49));
+    std::vector<uint8_t> bytes = readAll(BT_MAX_CHUNK_SIZE);
+    CHECK_EQUAL((closed - 50) * sizeof(SampleRecord), bytes.size());
+    const SampleRecord* records = (const SampleRecord*) bytes.data();
+    for (uint32_t i = 0; i < bytes.size() / sizeof(SampleRecord); i++)
+    {
+        CHECK_EQUAL(START + 50 + i, records[i].time);
+        CHECK_EQUAL((START + 50 + i) % 4000, records[i].distance);
+    }
+    CHECK_EQUAL(closed - 50, bluetoothFileManager.getRecordCount());
+    CHECK_EQUAL(START + closed - 1, bluetoothFileManager.getLastRecordTime());
+
+    // Across a file boundary, every third sample
+    CHECK(bluetoothFileManager.loadRange(START + 90, START + 119, 3));
+    bytes = readAll(BT_MAX_CHUNK_SIZE);
+    CHECK_EQUAL(10 * sizeof(SampleRecord), bytes.size());
+    records = (const SampleRecord*) bytes.data();
+    for (uint32_t i = 0; i < bytes.size() / sizeof(SampleRecord); i++)
+    {
+        CHECK_EQUAL(START + 90 + 3 * i, records[i].time);
+    }
+    bluetoothFileManager.clearFile();
+}
+
+/**
+ * @brief Directory pages carry on from their cursors and end on the last entry
+ *
+ */
+static void testDirectory(void)
+{
+    // Four data files and the catalog
+    std::vector<std::string> names;
+    uint32_t cursor = 0;
+    bool end = false;
+    for (int page = 0; page < 10 && !end; page++)
+    {
+        CHECK(bluetoothFileManager.openDirectory("/Data", cursor, 2));
+        uint8_t buffer[BT_CHUNK_SIZE];
+        size_t length;
+        while ((length = bluetoothFileManager.readDirectory(buffer, sizeof(buffer))) > 0)
+        {
+            size_t at = 0;
+            while (at < length)
+            {
+                DirEntry entry;
+                memcpy(&entry, buffer + at, sizeof(entry));
+                names.push_back(std::string((const char*) buffer + at + sizeof(entry), entry.nameLength));
+                if (names.back() != "index.bin") CHECK(entry.startTime >= START);
+                at += sizeof(entry) + entry.nameLength;
+            }
+        }
+        end = bluetoothFileManager.isDirectoryEnd();
+        cursor = bluetoothFileManager.getDirectoryCursor();
+        bluetoothFileManager.closeDirectory();
+    }
+    CHECK(end);
+    CHECK_EQUAL(FILES + 1, names.size());
+}
+
+int main()
+{
+    SD.format();
+    SD_Data sd(SD_CS);
+    sd.writeHeader();
+    std::vector<String> paths;
+
+    sdBus.lock();
+    for (uint32_t file = 0; file < FILES; file++)
+    {
+        uint32_t first = START + file * PER_FILE;
+        CHECK(sd.openDataFile(first));
+        paths.push_back(sd.getDataFilePath());
+        for (uint32_t time = first; time < first + PER_FILE; time++)
+        {
+            sd.appendData(time % 4000, time, 3.7f, 85.0f);
+        }
+    }
+    sdBus.unlock();
+
+    testLoadFile(paths);
+    testBusyFile(paths.back());
+    testQueries();
+    testDirectory();
+
+    sdBus.lock();
+    sd.sleep();
+    sdBus.unlock();
+    return hostTestResult();
+}
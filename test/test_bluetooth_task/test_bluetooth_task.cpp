@@ -0,0 +1,361 @@
+/**
+ * @file test_bluetooth_task.cpp
+ * @brief The Bluetooth task against a central the test plays, in simulated time
+ * @details The task runs on the test's own thread. Whenever it would block the
+ *          clock jumps, step() fires whatever the central does at that time,
+ *          stands in for the SD task and stops the task once a scenario is
+ *          over.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include <ArduinoBLE.h>
+#include <SdFat.h>
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include "hostTest.h"
+#include "setup.h"
+#include "sharedData.h"
+#include "waterSenseLibs/bluetooth/bluetooth.h"
+#include "waterSenseLibs/crc32/crc32.h"
+#include "waterSenseLibs/sdData/sdData.h"
+#include "waterSenseLibs/sdData/sdBus.h"
+#include "waterSenseTasks/taskBluetooth/taskBluetooth.h"
+
+extern SdFat SD;
+extern BluetoothFileManager bluetoothFileManager;
+
+#define REQUEST_UUID "12345678-1234-5678-1234-56789abcdef2"
+#define CHUNK_UUID "12345678-1234-5678-1234-56789abcdef3"
+#define STATUS_UUID "12345678-1234-5678-1234-56789abcdef5"
+#define BLOCK_CRC_UUID "12345678-1234-5678-1234-56789abcdef7"
+#define DIR_LIST_UUID "12345678-1234-5678-1234-56789abcdef8"
+
+/// Thrown from step() to end a scenario
+struct Stop {};
+
+/// Something the central does at a time
+struct Action
+{
+    uint64_t at;
+    std::function<void()> run;
+};
+
+static std::vector<Action> actions; ///< What is left of the scenario
+static uint64_t stopAt = 0; ///< When the scenario ends
+static uint64_t stalledAt = 0; ///< When TRANSFER_STALLED or LIST_STALLED went out, 0 until it has
+static uint64_t checkedInAt = 0; ///< When the task last checked in with the watchdog
+static uint64_t longestSilence = 0; ///< Most ms the task went without checking in
+static uint32_t rollovers = 0; ///< SD_ROLLOVER requests the SD task was sent
+
+/// Called every time the simulated clock moves
+static void step(uint64_t now)
+{
+    // The SD task, nothing is written
+    SDRequest request;
+    while (xQueueReceive(sdRequests.get_handle(), &request, 0) == pdTRUE)
+    {
+        if (request.type == SD_ROLLOVER)
+        {
+            rollovers++;
+            taskFlags.set(FLAG_SD_ROLLOVER_DONE);
+        }
+    }
+
+    const std::string& status = hostCentral.last(STATUS_UUID);
+    if (!stalledAt && (status == "TRANSFER_STALLED" || status == "LIST_STALLED")) stalledAt = now;
+
+    // The watchdog task, without the abort
+    if (watchChecks.is_set(CHECK_BLUETOOTH))
+    {
+        watchChecks.clear(CHECK_BLUETOOTH);
+        checkedInAt = now;
+    }
+    if (now - checkedInAt > longestSilence) longestSilence = now - checkedInAt;
+
+    for (size_t i = 0; i < actions.size(); i++)
+    {
+        if (actions[i].at <= now)
+        {
+            std::function<void()> run = actions[i].run;
+            actions.erase(actions.begin() + i--);
+            run();
+        }
+    }
+    if (now >= stopAt) throw Stop();
+}
+
+/// Run the task from a fresh wake until stopAt, what the central saw is kept for the checks
+static void runTask(uint64_t until)
+{
+    hostCentral.reset();
+    stopAt = until;
+    stalledAt = 0;
+    checkedInAt = 0;
+    longestSilence = 0;
+    rollovers = 0;
+    taskFlags.set(FLAG_WAKE_READY);
+    hostSimulateTime(step);
+    try
+    {
+        taskBluetooth(NULL);
+    }
+    catch (Stop&)
+    {
+    }
+    hostSimulateTime(NULL);
+    actions.clear();
+}
+
+/// Everything notified on a characteristic, back to back
+static std::string joined(const char* uuid)
+{
+    std::string all;
+    for (const std::string& part : hostCentral.notified[uuid]) all += part;
+    return all;
+}
+
+/// Put a file of length bytes on the card, returns its contents
+static std::string makeFile(const char* path, uint32_t length)
+{
+    std::string contents;
+    for (uint32_t i = 0; i < length; i++) contents += (char) ('a' + (i * 7) % 26);
+
+    ExFile file = SD.open(path, O_RDWR | O_CREAT | O_TRUNC);
+    file.write(contents.data(), contents.size());
+    file.close();
+    return contents;
+}
+
+/// A client that asks for a file and never subscribes to the chunks gets a status, not a hang
+static void testGetStall()
+{
+    makeFile("/Data/stall.txt", 3000);
+
+    actions.push_back({3000, [] { hostCentral.connect(); }});
+    actions.push_back({3500, [] {
+        hostCentral.subscribe(STATUS_UUID);
+        hostCentral.write(REQUEST_UUID, "GET /Data/stall.txt");
+    }});
+    runTask(20000);
+
+    CHECK(stalledAt >= 3500 + BT_STALL_TIMEOUT);
+    CHECK(stalledAt < 3500 + BT_STALL_TIMEOUT + 1000);
+    CHECK(longestSilence < WATCH_CHECK_PERIOD);
+    CHECK_EQUAL(0, bluetoothFileManager.getFileSize());
+    CHECK(hostCentral.notified[CHUNK_UUID].empty());
+}
+
+/// The same file with the chunks subscribed to goes out whole
+static void testGetComplete()
+{
+    std::string contents = makeFile("/Data/whole.txt", 3000);
+
+    actions.push_back({3000, [] { hostCentral.connect(); }});
+    actions.push_back({3500, [] {
+        hostCentral.subscribe(STATUS_UUID);
+        hostCentral.subscribe(CHUNK_UUID);
+        hostCentral.write(REQUEST_UUID, "/Data/whole.txt");
+    }});
+    runTask(20000);
+
+    CHECK(joined(CHUNK_UUID) == contents);
+    CHECK_EQUAL(0, stalledAt);
+    bool complete = false;
+    for (const std::string& status : hostCentral.notified[STATUS_UUID]) complete |= (status == "TRANSFER_COMPLETE");
+    CHECK(complete);
+}
+
+/// A GET whose block CRCs only go out on the second try still sends every one, each before its data
+static void testBlockCrcRetry()
+{
+    static std::string contents;
+    contents = makeFile("/Data/blocks.txt", 3000);
+
+    static uint32_t crcTries;
+    static uint32_t crcCovered; ///< Bytes of the file the CRCs sent so far cover
+    static uint32_t early; ///< Chunks sent before the CRC of their data
+    crcTries = 0;
+    crcCovered = 0;
+    early = 0;
+
+    actions.push_back({3000, [] { hostCentral.connect(); }});
+    actions.push_back({3500, [] {
+        hostCentral.subscribe(STATUS_UUID);
+        hostCentral.subscribe(CHUNK_UUID);
+        hostCentral.subscribe(BLOCK_CRC_UUID);
+        hostCentral.accept = [](const std::string& uuid, const uint8_t* data, int length) {
+            if (uuid == BLOCK_CRC_UUID)
+            {
+                if (crcTries++ % 2 == 0) return false; // No buffer free
+                BlockCrc blockCrc;
+                memcpy(&blockCrc, data, sizeof(blockCrc));
+                crcCovered = blockCrc.offset + blockCrc.length;
+            }
+            else if (uuid == CHUNK_UUID)
+            {
+                uint32_t offset;
+                memcpy(&offset, data, sizeof(offset));
+                if (offset + length - BT_FRAME_HEADER_SIZE > crcCovered) early++;
+            }
+            return true;
+        };
+        hostCentral.write(REQUEST_UUID, "GET /Data/blocks.txt");
+    }});
+    runTask(20000);
+
+    std::vector<std::string>& crcs = hostCentral.notified[BLOCK_CRC_UUID];
+    CHECK_EQUAL((contents.size() + BT_BLOCK_SIZE - 1) / BT_BLOCK_SIZE, crcs.size());
+    for (size_t i = 0; i < crcs.size(); i++)
+    {
+        BlockCrc blockCrc;
+        memcpy(&blockCrc, crcs[i].data(), sizeof(blockCrc));
+        CHECK_EQUAL(i * BT_BLOCK_SIZE, blockCrc.offset);
+        CHECK_EQUAL(crc32Update(0, &contents[blockCrc.offset], blockCrc.length), blockCrc.crc);
+    }
+    CHECK_EQUAL(0, early);
+    CHECK_EQUAL(0, stalledAt);
+
+    // And the data itself, without the offsets
+    std::string sent;
+    for (const std::string& part : hostCentral.notified[CHUNK_UUID]) sent += part.substr(BT_FRAME_HEADER_SIZE);
+    CHECK(sent == contents);
+}
+
+/// A client that takes the data but never the CRCs stalls the transfer the same way
+static void testBlockCrcStall()
+{
+    makeFile("/Data/nocrc.txt", 3000);
+
+    actions.push_back({3000, [] { hostCentral.connect(); }});
+    actions.push_back({3500, [] {
+        hostCentral.subscribe(STATUS_UUID);
+        hostCentral.subscribe(CHUNK_UUID);
+        hostCentral.write(REQUEST_UUID, "GET /Data/nocrc.txt");
+    }});
+    runTask(20000);
+
+    CHECK(stalledAt >= 3500 + BT_STALL_TIMEOUT);
+    CHECK(hostCentral.notified[CHUNK_UUID].empty());
+}
+
+/// A listing of a directory names every file in it and ends the page
+static void testList()
+{
+    actions.push_back({3000, [] { hostCentral.connect(); }});
+    actions.push_back({3500, [] {
+        hostCentral.subscribe(STATUS_UUID);
+        hostCentral.subscribe(DIR_LIST_UUID);
+        hostCentral.write(REQUEST_UUID, "LIST /Data");
+    }});
+    runTask(10000);
+
+    // Each notification holds whole entries, a DirEntry then its name
+    std::vector<std::string> names;
+    for (const std::string& part : hostCentral.notified[DIR_LIST_UUID])
+    {
+        size_t at = 0;
+        while (at + sizeof(DirEntry) <= part.size())
+        {
+            DirEntry entry;
+            memcpy(&entry, &part[at], sizeof(entry));
+            names.push_back(part.substr(at + sizeof(entry), entry.nameLength));
+            at += sizeof(entry) + entry.nameLength;
+        }
+        CHECK_EQUAL(part.size(), at);
+    }
+    CHECK_EQUAL(4, names.size()); // The files the tests before made
+    CHECK(std::find(names.begin(), names.end(), "stall.txt") != names.end());
+    CHECK(hostCentral.last(STATUS_UUID) == "LIST_END");
+}
+
+/// A client that never subscribed to the listing is given up on, checking in all the while
+static void testListStall()
+{
+    actions.push_back({3000, [] { hostCentral.connect(); }});
+    actions.push_back({3500, [] {
+        hostCentral.subscribe(STATUS_UUID);
+        hostCentral.write(REQUEST_UUID, "LIST /Data");
+    }});
+    runTask(20000);
+
+    CHECK(stalledAt >= 3500 + BT_STALL_TIMEOUT);
+    CHECK(stalledAt < 3500 + BT_STALL_TIMEOUT + 1000);
+    CHECK(longestSilence < WATCH_CHECK_PERIOD);
+    CHECK(hostCentral.notified[DIR_LIST_UUID].empty());
+}
+
+/// Ask for samples over a fresh connection, returns the status the transfer ended with, rollovers counts its own
+static std::string query(const char* request)
+{
+    static const char* text;
+    text = request;
+    actions.push_back({3000, [] { hostCentral.connect(); }});
+    actions.push_back({3500, [] {
+        hostCentral.subscribe(STATUS_UUID);
+        hostCentral.subscribe(CHUNK_UUID);
+        hostCentral.write(REQUEST_UUID, text);
+    }});
+    runTask(8000);
+
+    // The last sample's status comes just before the throughput and TRANSFER_COMPLETE
+    std::vector<std::string>& statuses = hostCentral.notified[STATUS_UUID];
+    return statuses.size() >= 3 ? statuses[statuses.size() - 3] : "";
+}
+
+/// A query only makes the SD task start a new data file when it needs samples from the open one
+static void testRolloverOnlyWhenNeeded()
+{
+    SD.format();
+    SD_Data sd(SD_CS);
+    sd.writeHeader();
+
+    const uint32_t start = 1700000000;
+    sdBus.lock();
+    CHECK(sd.openDataFile(start));
+    for (uint32_t time = start; time < start + 100; time++) sd.appendData(1, time, 3.7f, 85.0f);
+    CHECK(sd.openDataFile(start + 1000));
+    for (uint32_t time = start + 1000; time < start + 1100; time++) sd.appendData(1, time, 3.7f, 85.0f);
+    sdBus.unlock();
+
+    // Only the closed file, left alone
+    char request[64];
+    snprintf(request, sizeof(request), "QUERY %u %u", start + 10, start + 500);
+    CHECK(query(request) == "QUERY_LAST " + std::to_string(start + 99) + " 90");
+    CHECK_EQUAL(0, rollovers);
+
+    // Into the open file
+    snprintf(request, sizeof(request), "QUERY %u %u", start + 10, start + 1050);
+    query(request);
+    CHECK_EQUAL(1, rollovers);
+
+    // Everything newer than a sample, which the open file may hold
+    snprintf(request, sizeof(request), "SINCE %u", start + 50);
+    query(request);
+    CHECK_EQUAL(1, rollovers);
+
+    sdBus.lock();
+    sd.sleep();
+    sdBus.unlock();
+}
+
+int main()
+{
+    SD.format();
+    SD.mkdir("/Data");
+
+    testGetStall();
+    testGetComplete();
+    testBlockCrcRetry();
+    testBlockCrcStall();
+    testList();
+    testListStall();
+    testRolloverOnlyWhenNeeded();
+
+    return hostTestResult();
+}
@@ -0,0 +1,106 @@
+/**
+ * @file test_crc32.cpp
+ * @brief crc32Update() against zlib's CRC32, and how fast it is
+ * @details The slice-by-4 tables must give the same CRC as one byte at a
+ *          time, fed in any pieces. The benchmark times both, and the
+ *          rotate-xor checksum BLE transfers used before, over 512 byte
+ *          blocks like a transfer reads them.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "hostTest.h"
+#include "waterSenseLibs/crc32/crc32.h"
+
+#define BENCH_BYTES (16UL << 20) ///< Bytes checksummed by each benchmark run
+#define BENCH_BLOCK 512 ///< Bytes per call, one sector
+
+/// CRC32 a byte at a time, what the tables are checked against
+static uint32_t crc32Bytewise(uint32_t crc, const uint8_t* data, size_t length)
+{
+    static uint32_t table[256];
+    if (!table[1])
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (uint8_t bit = 0; bit < 8; bit++) c = (c & 1) ? (0xEDB88320UL ^ (c >> 1)) : (c >> 1);
+            table[i] = c;
+        }
+    }
+
+    crc ^= 0xFFFFFFFFUL;
+    while (length--) crc = table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFUL;
+}
+
+/// The checksum BLE transfers used before CRC32
+static uint32_t rotateXor(uint32_t checksum, const uint8_t* data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        checksum = ((checksum << 1) + (uint32_t) (char) data[i]) ^ (checksum >> 31);
+    }
+    return checksum;
+}
+
+/// MB/s of a checksum over BENCH_BYTES in BENCH_BLOCK pieces, the result goes to sink
+template <class Checksum>
+static double bench(const std::vector<uint8_t>& data, Checksum checksum, uint32_t& sink)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint32_t crc = 0;
+    for (size_t done = 0; done < BENCH_BYTES; done += BENCH_BLOCK)
+    {
+        crc = checksum(crc, &data[done % data.size()], BENCH_BLOCK);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    sink ^= crc;
+    return BENCH_BYTES / seconds / 1e6;
+}
+
+int main()
+{
+    // The check value of the CRC-32 used by zlib
+    CHECK_EQUAL(0xCBF43926UL, crc32Update(0, "123456789", 9));
+    CHECK_EQUAL(0, crc32Update(0, "", 0));
+
+    std::mt19937 random(1);
+    std::vector<uint8_t> data(64 * BENCH_BLOCK);
+    for (size_t i = 0; i < data.size(); i++) data[i] = random();
+
+    // Any split, any alignment, the same CRC as one byte at a time
+    uint32_t whole = crc32Bytewise(0, data.data(), data.size());
+    CHECK_EQUAL(whole, crc32Update(0, data.data(), data.size()));
+    for (size_t piece = 1; piece <= 13; piece++)
+    {
+        uint32_t crc = 0;
+        for (size_t done = 0; done < data.size(); done += piece)
+        {
+            crc = crc32Update(crc, &data[done], std::min(piece, data.size() - done));
+        }
+        CHECK_EQUAL(whole, crc);
+    }
+    for (size_t start = 0; start < 8; start++)
+    {
+        CHECK_EQUAL(crc32Bytewise(0, &data[start], 1001), crc32Update(0, &data[start], 1001));
+    }
+
+    uint32_t sink = 0;
+    double old = bench(data, rotateXor, sink);
+    double bytewise = bench(data, crc32Bytewise, sink);
+    double sliced = bench(data, [](uint32_t crc, const uint8_t* block, size_t length) { return crc32Update(crc, block, length); }, sink);
+    printf("%lu MB in %u byte blocks (sink %08x)\n", BENCH_BYTES >> 20, BENCH_BLOCK, sink);
+    printf("  rotate-xor checksum  %7.0f MB/s\n", old);
+    printf("  byte table CRC32     %7.0f MB/s\n", bytewise);
+    printf("  crc32Update()        %7.0f MB/s\n", sliced);
+
+    return hostTestResult();
+}
@@ -0,0 +1,74 @@
+/**
+ * @file test_data_append.cpp
+ * @brief What appending samples costs the card
+ * @details Samples go through the data file SD_Data keeps open: the file is
+ *          opened once per wake and per rollover, synced every SD_SYNC_RECORDS
+ *          samples, and rolled over at MAX_FILESIZE without looking the file
+ *          up again. Prints the operations per sample it measured.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include "hostTest.h"
+#include "setup.h"
+#include "sharedData.h"
+#include "waterSenseLibs/sdData/sdData.h"
+#include "waterSenseLibs/sdData/sdBus.h"
+
+static const uint32_t START = 0x60000000; ///< Time of the first sample
+
+int main()
+{
+    SD.format();
+    SD_Data sd(SD_CS);
+    sd.writeHeader();
+
+    sdBus.lock();
+    sdBus.resetStats();
+    SD.card()->resetStats();
+
+    // One file, well short of MAX_FILESIZE
+    const uint32_t samples = 1000;
+    CHECK(sd.openDataFile(START));
+    String first = sd.getDataFilePath();
+    for (uint32_t time = START; time < START + samples; time++)
+    {
+        sd.appendData(time % 4000, time, 3.7f, 85.0f);
+    }
+    CHECK(sd.getDataFilePath() == first);
+
+    // The data file and the catalog, each opened once
+    SDStats stats = sdBus.getStats();
+    CHECK_EQUAL(2, stats.opens);
+    // The new catalog and its first entry, then one per SD_SYNC_RECORDS samples
+    CHECK_EQUAL(2 + samples / SD_SYNC_RECORDS, stats.syncs);
+    RamBlockStats card = SD.card()->getStats();
+    CHECK(card.syncs <= stats.syncs);
+
+    printf("%u samples: %.3f opens, %.3f syncs, %.3f writes, %.3f card sectors written per sample\n",
+        (unsigned) samples, (double) stats.opens / samples, (double) stats.syncs / samples,
+        (double) stats.writes / samples, (double) card.sectorsWritten / samples);
+
+    // Keep going until it rolls over, that is the only other open
+    uint32_t time = START + samples;
+    while (sd.getDataFilePath() == first)
+    {
+        sd.appendData(time % 4000, time, 3.7f, 85.0f);
+        time++;
+    }
+    CHECK_EQUAL(3, sdBus.getStats().opens);
+
+    ExFile file = SD.open(first.c_str(), O_RDONLY);
+    CHECK(file.fileSize() >= MAX_FILESIZE);
+    CHECK(file.fileSize() < MAX_FILESIZE + 48);
+    file.close();
+
+    sd.sleep();
+    sdBus.unlock();
+    return hostTestResult();
+}
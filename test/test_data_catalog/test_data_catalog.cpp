@@ -0,0 +1,125 @@
+/**
+ * @file test_data_catalog.cpp
+ * @brief The catalog's search when the clock was set back between files
+ * @details A file that starts before the one it follows starts a new
+ *          generation. Every window is checked against a scan of all the
+ *          entries: each file that covers it must be in the span, and the
+ *          span must start and end on one that does.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include "hostTest.h"
+#include "waterSenseLibs/dataCatalog/dataCatalog.h"
+
+extern SdFat SD;
+
+/// Append a closed file of samples from first to last
+static void append(DataCatalog& catalog, uint32_t first, uint32_t last, uint16_t flags = 0)
+{
+    CatalogEntry entry = {};
+    entry.nameTime = first;
+    entry.firstTime = first;
+    entry.lastTime = last;
+    entry.records = last - first + 1;
+    entry.flags = flags;
+    entry.generation = 7; // Not the caller's to set
+    CHECK(catalog.write(catalog.size(), entry));
+}
+
+/// Check find() against every entry for windows across the whole catalog
+static void checkWindows(DataCatalog& catalog)
+{
+    for (uint32_t t0 = 0; t0 <= 5000; t0 += 50)
+    {
+        for (uint32_t t1 = t0; t1 <= 5000; t1 += 150)
+        {
+            CatalogSpan span = catalog.find(t0, t1);
+            for (uint32_t i = 0; i < catalog.size(); i++)
+            {
+                CatalogEntry entry;
+                CHECK(catalog.read(i, entry));
+                bool inSpan = i >= span.first && i < span.first + span.count;
+                if (DataCatalog::covers(entry, t0, t1)) CHECK(inSpan);
+                if (inSpan && (i == span.first || i == span.first + span.count - 1)) CHECK(DataCatalog::covers(entry, t0, t1));
+            }
+        }
+    }
+}
+
+int main()
+{
+    SD.format();
+    SD.mkdir("/Data");
+
+    DataCatalog catalog;
+    CHECK(catalog.begin(true));
+    CHECK_EQUAL(0, catalog.size());
+
+    append(catalog, 1000, 1999);
+    append(catalog, 2000, 2999);
+    append(catalog, 3000, 3999);
+    append(catalog, 1500, 2499); // Set back
+    append(catalog, 2500, 3499);
+    append(catalog, 500, 899); // And again
+    append(catalog, 4000, 4000, CATALOG_OPEN);
+
+    const uint32_t generations[] = {0, 0, 0, 1, 1, 2, 2};
+    CHECK_EQUAL(7, catalog.size());
+    for (uint32_t i = 0; i < catalog.size(); i++)
+    {
+        CatalogEntry entry;
+        CHECK(catalog.read(i, entry));
+        CHECK_EQUAL(generations[i], entry.generation);
+    }
+
+    // 2200 is in the second file and in the fourth, the third is in the span but misses
+    CatalogSpan span = catalog.find(2200, 2300);
+    CHECK_EQUAL(1, span.first);
+    CHECK_EQUAL(3, span.count);
+
+    // Only the first generation reaches 3600, the open file at the end might
+    span = catalog.find(3600, 5000);
+    CHECK_EQUAL(2, span.first);
+    CHECK_EQUAL(5, span.count);
+
+    checkWindows(catalog);
+
+    // Closing the open file keeps its generation whatever the caller's copy says
+    CatalogEntry last;
+    CHECK(catalog.read(6, last));
+    last.lastTime = 4500;
+    last.flags = 0;
+    last.generation = 0;
+    CHECK(catalog.write(6, last));
+    CHECK(catalog.read(6, last));
+    CHECK_EQUAL(2, last.generation);
+
+    // The same answers from a reader that opens it later
+    catalog.end();
+    DataCatalog reader;
+    CHECK(reader.begin(false));
+    CHECK_EQUAL(7, reader.size());
+    checkWindows(reader);
+
+    // A catalog that was never set back is one generation
+    SD.format();
+    SD.mkdir("/Data");
+    DataCatalog sorted;
+    CHECK(sorted.begin(true));
+    for (uint32_t i = 0; i < 100; i++) append(sorted, 1000 + 10 * i, 1009 + 10 * i);
+    CatalogEntry entry;
+    CHECK(sorted.read(99, entry));
+    CHECK_EQUAL(0, entry.generation);
+    span = sorted.find(1405, 1423);
+    CHECK_EQUAL(40, span.first);
+    CHECK_EQUAL(3, span.count);
+    checkWindows(sorted);
+
+    return hostTestResult();
+}
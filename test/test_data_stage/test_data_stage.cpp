@@ -0,0 +1,150 @@
+/**
+ * @file test_data_stage.cpp
+ * @brief Samples are written to the card in whole sectors
+ * @details Counts the writes to every sector of the data file on the RAM
+ *          card. Built twice, for CSV rows and, with SD_BINARY_LOG, for
+ *          binary records. Prints the samples per card write it measured.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include "hostTest.h"
+#include "setup.h"
+#include "sharedData.h"
+#include "waterSenseLibs/sdData/sdData.h"
+#include "waterSenseLibs/sdData/sdBus.h"
+
+static const uint32_t START = 0x60000000; ///< Time of the first sample
+
+/// The data file as it is on the card
+static ExFile openOnCard(SD_Data& sd)
+{
+    return SD.open(sd.getDataFilePath().c_str(), O_RDONLY);
+}
+
+/// Highest number of writes to any sector in [first, first + count)
+static uint32_t mostWrites(uint32_t first, uint32_t count)
+{
+    uint32_t most = 0;
+    for (uint32_t sector = first; sector < first + count; sector++)
+    {
+        if (SD.card()->writeCount(sector) > most) most = SD.card()->writeCount(sector);
+    }
+    return most;
+}
+
+/**
+ * @brief Appending only ever writes a sector of the file once
+ *
+ */
+static void testWholeSectors(void)
+{
+    SD.format();
+    SD_Data sd(SD_CS);
+    sd.writeHeader();
+
+    sdBus.lock();
+    CHECK(sd.openDataFile(START));
+    sdBus.resetStats();
+
+    const uint32_t samples = 1000;
+    for (uint32_t time = START; time < START + samples; time++)
+    {
+        sd.appendData(time % 4000, time, 3.7f, 85.0f);
+    }
+
+    // Only data writes since the reset, each a whole number of sectors.
+    // SD_SYNC_RECORDS samples take less than a sector, so every sector is
+    // written on its own as soon as a sync finds it complete.
+    const SDStats stats = sdBus.getStats();
+    CHECK_EQUAL(stats.bytes, stats.sectors * SD_SECTOR_SIZE);
+    CHECK_EQUAL(stats.writes, stats.sectors);
+    double perWrite = (double) samples / stats.writes;
+#ifdef SD_BINARY_LOG
+    // 32 units to a sector, less one block trailer
+    CHECK(perWrite > 30 && perWrite < 32);
+    printf("Binary records: %.1f samples per card write\n", perWrite);
+#else
+    CHECK(perWrite > 15 && perWrite < 20);
+    printf("CSV rows: %.1f samples per card write\n", perWrite);
+#endif
+
+    ExFile file = openOnCard(sd);
+    uint32_t first = file.firstSector();
+    uint32_t onCard = file.fileSize();
+    file.close();
+    CHECK(first != 0);
+    CHECK_EQUAL(0, onCard % SD_SECTOR_SIZE);
+    CHECK_EQUAL(1, mostWrites(first, onCard / SD_SECTOR_SIZE));
+
+    // Closing writes the partial sector, once
+    sd.closeDataFile();
+    file = SD.open(sd.getDataFilePath().c_str(), O_RDONLY);
+    uint32_t closed = file.fileSize();
+    file.close();
+    CHECK(closed > onCard);
+    CHECK_EQUAL(1, mostWrites(first, (closed + SD_SECTOR_SIZE - 1) / SD_SECTOR_SIZE));
+
+    sd.sleep();
+    sdBus.unlock();
+}
+
+/**
+ * @brief SD_FLUSH puts the partial sector on the card, at the cost of writing it again
+ *
+ */
+static void testFlushPartial(void)
+{
+    SD.format();
+    SD_Data sd(SD_CS);
+    sd.writeHeader();
+
+    sdBus.lock();
+    CHECK(sd.openDataFile(START));
+    sd.syncData(true);
+
+    uint32_t time = START;
+    for (int i = 0; i < 5; i++, time++) sd.appendData(time % 4000, time, 3.7f, 85.0f);
+
+    // A plain sync leaves the samples in RAM, a flush does not
+    sd.syncData();
+    ExFile file = openOnCard(sd);
+    uint32_t synced = file.fileSize();
+    file.close();
+    sd.syncData(true);
+    file = openOnCard(sd);
+    uint32_t flushed = file.fileSize();
+    uint32_t first = file.firstSector();
+    file.close();
+    CHECK(synced < SD_SECTOR_SIZE);
+    CHECK(flushed > synced);
+    CHECK(flushed < SD_SECTOR_SIZE);
+
+    // Fill the sector, it is written once more and the rest once
+    while (time < START + 200)
+    {
+        sd.appendData(time % 4000, time, 3.7f, 85.0f);
+        time++;
+    }
+    sd.closeDataFile();
+    file = SD.open(sd.getDataFilePath().c_str(), O_RDONLY);
+    uint32_t sectors = (file.fileSize() + SD_SECTOR_SIZE - 1) / SD_SECTOR_SIZE;
+    file.close();
+    CHECK(SD.card()->writeCount(first) >= 2);
+    CHECK_EQUAL(1, mostWrites(first + 1, sectors - 1));
+
+    sd.sleep();
+    sdBus.unlock();
+}
+
+int main()
+{
+    testWholeSectors();
+    testFlushPartial();
+    return hostTestResult();
+}
@@ -0,0 +1,55 @@
+/**
+ * @file test_gnss_buffer.cpp
+ * @brief The GNSS buffer pool's hand-over and counters
+ * @details A producer that finds no free buffer and retries has lost
+ *          nothing, only a block that is given back unwritten counts as an
+ *          overflow, against the buffer it was in
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include "hostTest.h"
+#include "waterSenseLibs/gnssBuffer/gnssBuffer.h"
+
+int main()
+{
+    GNSSBufferPool pool(2, 64, "Test Buffers");
+
+    uint8_t first;
+    uint8_t second;
+    uint8_t spare;
+    CHECK(pool.acquire(first) != NULL);
+    CHECK(pool.acquire(second) != NULL);
+    CHECK(first != second);
+    CHECK_EQUAL(2, pool.getHighWater());
+
+    // The clock task retries until the SD task hands a buffer back
+    for (int i = 0; i < 100; i++) CHECK(pool.acquire(spare) == NULL);
+    CHECK_EQUAL(0, pool.getOverflows(first));
+    CHECK_EQUAL(0, pool.getOverflows(second));
+
+    // Written and handed back
+    pool.release(first);
+    CHECK(pool.acquire(spare) == pool.data(first));
+    CHECK_EQUAL(first, spare);
+
+    // The request queue was full, the block in the second buffer is lost
+    pool.drop(second);
+    CHECK_EQUAL(0, pool.getOverflows(first));
+    CHECK_EQUAL(1, pool.getOverflows(second));
+    CHECK(pool.acquire(spare) == pool.data(second));
+
+    // Too late for the SD task, lost as well
+    pool.drop(first);
+    pool.drop(second);
+    CHECK_EQUAL(1, pool.getOverflows(first));
+    CHECK_EQUAL(2, pool.getOverflows(second));
+    CHECK_EQUAL(2, pool.getHighWater());
+
+    pool.printStats(Serial);
+    return hostTestResult();
+}
@@ -0,0 +1,184 @@
+/**
+ * @file test_record_query.cpp
+ * @brief QUERY and SINCE against a brute-force filter of every sample written
+ * @details Four data files ten seconds a sample apart, with gaps between
+ *          them, then two more after the clock was set back. Each window,
+ *          and each decimation of it, must return exactly the samples a scan
+ *          of all of them picks, in the order they were written. Built
+ *          twice, for CSV rows and, with SD_BINARY_LOG, for binary records.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include <algorithm>
+#include <vector>
+#include "hostTest.h"
+#include "setup.h"
+#include "sharedData.h"
+#include "waterSenseLibs/sdData/sdData.h"
+#include "waterSenseLibs/sdData/sdBus.h"
+#include "waterSenseLibs/bluetooth/bluetooth.h"
+
+static const uint32_t START = 1700000000; ///< Time of the first sample
+static const uint32_t PER_FILE = 200; ///< Samples in each data file
+static const uint32_t FILES = 4; ///< Data files written
+static const uint32_t STEP = 10; ///< Seconds between samples
+static const uint32_t GAP = 1000; ///< Seconds between the last sample of a file and the first of the next
+
+static std::vector<uint32_t> written; ///< Time of every sample on the card
+
+/// The times of the samples the file manager returns for what is loaded
+static std::vector<uint32_t> readTimes(void)
+{
+    std::vector<uint32_t> times;
+    uint8_t chunk[BT_MAX_CHUNK_SIZE];
+    size_t length;
+    while ((length = bluetoothFileManager.readChunk(chunk, sizeof(chunk))) > 0)
+    {
+        CHECK_EQUAL(0, length % sizeof(SampleRecord));
+        for (size_t at = 0; at + sizeof(SampleRecord) <= length; at += sizeof(SampleRecord))
+        {
+            SampleRecord record;
+            memcpy(&record, chunk + at, sizeof(record));
+            times.push_back(record.time);
+        }
+    }
+    return times;
+}
+
+/// Check one window against a scan of everything written
+static void checkWindow(uint32_t t0, uint32_t t1, uint16_t decimate)
+{
+    std::vector<uint32_t> expected;
+    uint32_t matches = 0;
+    for (uint32_t time : written)
+    {
+        if (time >= t0 && time <= t1 && matches++ % (decimate ? decimate : 1) == 0) expected.push_back(time);
+    }
+
+    CHECK(bluetoothFileManager.loadRange(t0, t1, decimate));
+    std::vector<uint32_t> times = readTimes();
+    if (times != expected)
+    {
+        fprintf(stderr, "[%u, %u] / %u: %zu samples, expected %zu\n", t0, t1, decimate, times.size(), expected.size());
+    }
+    CHECK(times == expected);
+    CHECK_EQUAL(expected.size(), bluetoothFileManager.getRecordCount());
+    if (!expected.empty()) CHECK_EQUAL(expected.back(), bluetoothFileManager.getLastRecordTime());
+    bluetoothFileManager.clearFile();
+}
+
+int main()
+{
+    SD.format();
+    SD_Data sd(SD_CS);
+    sd.writeHeader();
+
+    sdBus.lock();
+    uint32_t time = START;
+    for (uint32_t file = 0; file < FILES; file++)
+    {
+        CHECK(sd.openDataFile(time));
+        for (uint32_t i = 0; i < PER_FILE; i++)
+        {
+            sd.appendData(i, time, 3.7f, 85.0f);
+            written.push_back(time);
+            time += STEP;
+        }
+        sd.closeDataFile();
+        time += GAP;
+    }
+    sd.sleep();
+    sdBus.unlock();
+
+    const uint32_t fileSpan = PER_FILE * STEP + GAP - STEP; ///< First sample of one file to the first of the next
+    const uint32_t last = written.back();
+    const uint32_t windows[][3] = {
+        {0, UINT32_MAX, 1}, // Everything
+        {START + 1000, START + 1500, 1}, // Inside one file
+        {START + fileSpan - 5, START + fileSpan + 1100, 7}, // Across the gap between files
+        {START + 2500, START + 2900, 1}, // Only the gap
+        {last - 10, last + 2000, 3}, // The end of the data
+        {last + 1000, last + 1000, 1}, // Past it
+        {5, 4, 1}, // Reversed
+        {START, START, 0} // One second
+    };
+    for (const uint32_t* window : windows)
+    {
+        checkWindow(window[0], window[1], window[2]);
+    }
+
+    // Windows starting and ending everywhere, on samples and between them
+    for (uint32_t t0 = START - 15; t0 < last + 15; t0 += 487)
+    {
+        for (uint32_t length = 0; length < 4 * fileSpan; length += 1313)
+        {
+            for (uint16_t decimate : {1, 3, 7})
+            {
+                checkWindow(t0, t0 + length, decimate);
+            }
+        }
+    }
+
+    // SINCE is everything after the newest sample the client has
+    CHECK(bluetoothFileManager.loadSince(written[PER_FILE + 3]));
+    std::vector<uint32_t> times = readTimes();
+    CHECK(times == std::vector<uint32_t>(written.begin() + PER_FILE + 4, written.end()));
+    bluetoothFileManager.clearFile();
+
+    // The clock set back into the first file, a second generation of files
+    // interleaved in time with the first. Both are returned, older first
+    sdBus.lock();
+    time = START + 505;
+    for (uint32_t file = 0; file < 2; file++)
+    {
+        CHECK(sd.openDataFile(time));
+        for (uint32_t i = 0; i < PER_FILE; i++)
+        {
+            sd.appendData(i, time, 3.7f, 85.0f);
+            written.push_back(time);
+            time += STEP;
+        }
+        sd.closeDataFile();
+        time += GAP;
+    }
+    sd.sleep();
+    sdBus.unlock();
+
+    const uint32_t setBack[][3] = {
+        {START + 1000, START + 1500, 1}, // Inside a file of each generation
+        {START + 500, START + fileSpan + 1100, 3}, // Across files of both
+        {0, UINT32_MAX, 1} // Everything
+    };
+    for (const uint32_t* window : setBack)
+    {
+        checkWindow(window[0], window[1], window[2]);
+    }
+
+    // The newer generation really does go back in time
+    CHECK(bluetoothFileManager.loadRange(START + 1000, START + 1500, 1));
+    times = readTimes();
+    CHECK(!times.empty() && !std::is_sorted(times.begin(), times.end()));
+    bluetoothFileManager.clearFile();
+
+    // Every window again, now that most of them reach into both generations
+    for (uint32_t t0 = START - 15; t0 < last + 15; t0 += 971)
+    {
+        for (uint32_t length = 0; length < 4 * fileSpan; length += 1717)
+        {
+            checkWindow(t0, t0 + length, 1);
+        }
+    }
+
+#ifdef SD_BINARY_LOG
+    printf("Binary records: %zu samples in %u files checked\n", written.size(), FILES + 2);
+#else
+    printf("CSV rows: %zu samples in %u files checked\n", written.size(), FILES + 2);
+#endif
+    return hostTestResult();
+}
@@ -0,0 +1,201 @@
+/**
+ * @file test_sample_codec.cpp
+ * @brief DELTA sample streams decode back to the raw ones, and how much smaller they are
+ * @details Writes a synthetic series through SD_Data, 9000 samples about a
+ *          minute apart with a drifting distance and a slowly falling
+ *          battery, and streams it with SINCE both ways. The DELTA stream is
+ *          decoded here the way tools/wsdelta2csv.py does. Built twice, for
+ *          CSV rows and, with SD_BINARY_LOG, for binary records. Prints the
+ *          bytes per sample, the ratios and what encoding costs.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "hostTest.h"
+#include "setup.h"
+#include "sharedData.h"
+#include "waterSenseLibs/sdData/sdData.h"
+#include "waterSenseLibs/sdData/sdBus.h"
+#include "waterSenseLibs/bluetooth/bluetooth.h"
+#include "waterSenseLibs/sampleCodec/sampleCodec.h"
+#include "waterSenseLibs/crc32/crc32.h"
+
+static const uint32_t FILES = 6; ///< Data files written
+static const uint32_t PER_FILE = 1500; ///< Samples in each
+
+/// Read one LEB128 varint, false if the stream ends inside it
+static bool getVarint(const std::vector<uint8_t>& data, size_t& at, uint32_t& value)
+{
+    value = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7)
+    {
+        if (at >= data.size()) return false;
+        uint8_t byte = data[at++];
+        value |= (uint32_t) (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+/// Decode a whole DELTA stream, CHECKs it ends on a sample
+static std::vector<SampleRecord> decode(const std::vector<uint8_t>& data)
+{
+    std::vector<SampleRecord> records;
+    SampleRecord previous = {};
+    size_t at = 0;
+    while (at < data.size())
+    {
+        uint32_t fields[4];
+        for (uint32_t& field : fields) CHECK(getVarint(data, at, field));
+
+        SampleRecord record;
+        record.time = previous.time + (uint32_t) ((fields[0] >> 1) ^ -(fields[0] & 1));
+        record.distance = (int32_t) ((uint32_t) previous.distance + ((fields[1] >> 1) ^ -(fields[1] & 1)));
+        uint32_t bits;
+        memcpy(&bits, &previous.battery, sizeof(bits));
+        bits ^= fields[2];
+        memcpy(&record.battery, &bits, sizeof(bits));
+        memcpy(&bits, &previous.batteryPercent, sizeof(bits));
+        bits ^= fields[3];
+        memcpy(&record.batteryPercent, &bits, sizeof(bits));
+
+        records.push_back(record);
+        previous = record;
+    }
+    return records;
+}
+
+/// Everything a SINCE 0 sends with a codec, CHECKs the transfer CRC covers what was sent
+static std::vector<uint8_t> stream(uint8_t codec)
+{
+    CHECK(bluetoothFileManager.setCodec(codec));
+    CHECK(bluetoothFileManager.loadSince(0));
+
+    std::vector<uint8_t> sent;
+    uint8_t chunk[BT_MAX_CHUNK_SIZE];
+    size_t length;
+    while ((length = bluetoothFileManager.readChunk(chunk, sizeof(chunk))) > 0)
+    {
+        sent.insert(sent.end(), chunk, chunk + length);
+    }
+    CHECK_EQUAL(FILES * PER_FILE, bluetoothFileManager.getRecordCount());
+    CHECK_EQUAL(crc32Update(0, sent.data(), sent.size()), bluetoothFileManager.getCurrentChecksum());
+    bluetoothFileManager.clearFile();
+    return sent;
+}
+
+/// Bitwise equality, so a float that changed its bits but not its value is caught
+static bool sameRecords(const std::vector<SampleRecord>& a, const std::vector<SampleRecord>& b)
+{
+    return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(SampleRecord)) == 0;
+}
+
+/// Values no real sample has still survive the round trip
+static void testExtremes(void)
+{
+    std::vector<SampleRecord> records = {
+        {0, 0, 0.0f, 0.0f},
+        {UINT32_MAX, INT32_MIN, -0.0f, NAN},
+        {0, INT32_MAX, INFINITY, -INFINITY},
+        {0x80000000, -1, 1e-40f, 3.4e38f},
+        {1, 1, 4.2f, 100.0f}
+    };
+
+    SampleEncoder encoder;
+    std::vector<uint8_t> encoded;
+    uint8_t out[SAMPLE_CODEC_MAX_SIZE];
+    for (const SampleRecord& record : records)
+    {
+        size_t length = encoder.encode(record, out);
+        CHECK(length <= SAMPLE_CODEC_MAX_SIZE);
+        encoded.insert(encoded.end(), out, out + length);
+    }
+    CHECK(sameRecords(records, decode(encoded)));
+}
+
+int main()
+{
+    testExtremes();
+
+    SD.format();
+    SD_Data sd(SD_CS);
+    sd.writeHeader();
+
+    std::mt19937 random(1);
+    uint32_t time = 1700000000;
+    int32_t distance = 1500;
+    float battery = 4.05f;
+
+    sdBus.lock();
+    for (uint32_t file = 0; file < FILES; file++)
+    {
+        CHECK(sd.openDataFile(time));
+        for (uint32_t i = 0; i < PER_FILE; i++)
+        {
+            distance += (int32_t) (random() % 7) - 3;
+            if (random() % 50 == 0) battery -= 0.0037f * (random() % 3);
+            sd.appendData(distance, time, battery, (battery - 3.3f) / 0.9f * 100);
+            time += 60 + (random() % 3 == 0);
+        }
+        sd.closeDataFile();
+    }
+    sd.sleep();
+    sdBus.unlock();
+
+    // The data files as they are on the card, not the catalog
+    uint32_t onCard = 0;
+    ExFile dir = SD.open("/Data", O_RDONLY);
+    ExFile next;
+    char name[32];
+    while (next.openNext(&dir, O_RDONLY))
+    {
+        next.getName(name, sizeof(name));
+        if (strcmp(name, "index.bin") != 0) onCard += next.fileSize();
+        next.close();
+    }
+    dir.close();
+
+    std::vector<uint8_t> raw = stream(CODEC_NONE);
+    std::vector<uint8_t> delta = stream(CODEC_DELTA);
+    CHECK_EQUAL(FILES * PER_FILE * sizeof(SampleRecord), raw.size());
+
+    std::vector<SampleRecord> records(raw.size() / sizeof(SampleRecord));
+    memcpy(records.data(), raw.data(), raw.size());
+    CHECK(sameRecords(records, decode(delta)));
+
+    // The encoder alone, over the same samples
+    SampleEncoder encoder;
+    uint8_t out[SAMPLE_CODEC_MAX_SIZE];
+    size_t encoded = 0;
+    const int passes = 200;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++)
+    {
+        encoder.reset();
+        for (const SampleRecord& record : records) encoded += encoder.encode(record, out);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / passes / records.size();
+    CHECK_EQUAL(passes * delta.size(), encoded);
+
+    double perSample = (double) delta.size() / records.size();
+    double ratio = (double) raw.size() / delta.size();
+    CHECK(ratio > 3.5);
+#ifdef SD_BINARY_LOG
+    printf("Binary files: %.2f B per sample, %.2fx smaller than records, %.2fx smaller than the files\n",
+        perSample, ratio, (double) onCard / delta.size());
+#else
+    printf("CSV files: %.2f B per sample, %.2fx smaller than records, %.2fx smaller than the files\n",
+        perSample, ratio, (double) onCard / delta.size());
+#endif
+    printf("Encoding: %.1f ns per sample, %.2f us per KB of records\n", ns, ns * 1024 / sizeof(SampleRecord) / 1000);
+
+    return hostTestResult();
+}
@@ -0,0 +1,197 @@
+/**
+ * @file test_sd_data.cpp
+ * @brief SD_Data, the event log and the catalog on the RAM card
+ * @details Checks the SD_STATS counters against the files the card ends up
+ *          holding, including a data file reopened with O_APPEND, and that
+ *          the event log and catalog writes are counted with the data writes
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include <SdFat.h>
+#include "hostTest.h"
+#include "setup.h"
+#include "sharedData.h"
+#include "waterSenseLibs/sdData/sdData.h"
+#include "waterSenseLibs/sdData/sdBus.h"
+#include "waterSenseLibs/eventLog/eventLog.h"
+
+/// Bytes of the CSV line SD_Data writes for a sample
+static uint32_t lineLength(int32_t distance, uint32_t time)
+{
+    char line[48];
+    return snprintf(line, sizeof(line), "%u, %d, %0.2f, %0.2f\n", time, distance, 3.7f, 85.0f);
+}
+
+/// Size of a file on the card, 0 if it does not exist
+static uint32_t fileSize(const String& path)
+{
+    ExFile file = SD.open(path.c_str(), O_RDONLY);
+    uint32_t size = file ? file.fileSize() : 0;
+    file.close();
+    return size;
+}
+
+/// Card sectors a run of sector aligned writes from start to end touches
+static uint32_t sectorsBetween(uint32_t start, uint32_t end)
+{
+    return (end - 1) / SD_SECTOR_SIZE - start / SD_SECTOR_SIZE + 1;
+}
+
+/// Check a data file holds exactly the samples first..first+count-1, one second apart
+static void checkSamples(const String& path, uint32_t first, uint32_t count)
+{
+    ExFile file = SD.open(path.c_str(), O_RDONLY);
+    CHECK(file);
+    char line[64];
+    uint32_t expected = first;
+    while (file.fgets(line, sizeof(line)) > 0)
+    {
+        unsigned long time;
+        long distance;
+        CHECK(sscanf(line, "%lu, %ld", &time, &distance) == 2);
+        CHECK_EQUAL(expected, time);
+        CHECK_EQUAL((long) (expected % 4000), distance);
+        expected++;
+    }
+    CHECK_EQUAL(first + count, expected);
+    file.close();
+}
+
+/**
+ * @brief Appends before and after a reopen, counted against what is on the card
+ *
+ */
+static void testDataStats(void)
+{
+    SD.format();
+    SD_Data sd(SD_CS);
+    sd.writeHeader();
+    const uint32_t start = 0x60000000;
+
+    sdBus.lock();
+    CHECK(sd.openDataFile(start));
+    String path = sd.getDataFilePath();
+
+    uint32_t time = start;
+    for (int i = 0; i < 17; i++, time++) sd.appendData(time % 4000, time, 3.7f, 85.0f);
+    sd.closeDataFile();
+
+    // Reopened with O_APPEND, the first write lands at the old end, not at 0.
+    // 17 samples end 2 bytes short of a sector, the next three are only written
+    // on close and cross into the next one.
+    const int counts[] = {3, 37};
+    for (int count : counts)
+    {
+        uint32_t closedSize = fileSize(path);
+        sdBus.resetStats();
+        uint32_t appended = 0;
+        for (int i = 0; i < count; i++, time++)
+        {
+            sd.appendData(time % 4000, time, 3.7f, 85.0f);
+            appended += lineLength(time % 4000, time);
+        }
+        sd.closeDataFile();
+        uint32_t finalSize = fileSize(path);
+        CHECK_EQUAL(closedSize + appended, finalSize);
+
+        // Reopening and closing each rewrite one catalog entry, one sector and one sync apiece
+        const SDStats& stats = sdBus.getStats();
+        CHECK_EQUAL(1, stats.opens);
+        CHECK_EQUAL(appended + 2 * CATALOG_ENTRY_SIZE, stats.bytes);
+        CHECK_EQUAL(sectorsBetween(closedSize, finalSize) + 2, stats.sectors);
+        CHECK_EQUAL(count / SD_SYNC_RECORDS + 2, stats.syncs);
+    }
+
+    checkSamples(path, start, time - start);
+    sd.sleep();
+    sdBus.unlock();
+}
+
+/**
+ * @brief A file reopened at MAX_FILESIZE rolls over without losing what it held
+ * @details The reopened file is closed before anything is written to it, so
+ *          its position is still 0 when the preallocation is trimmed
+ *
+ */
+static void testReopenAtLimit(void)
+{
+    SD.format();
+    SD_Data sd(SD_CS);
+    sd.writeHeader();
+    const uint32_t start = 0x60001000;
+
+    sdBus.lock();
+    CHECK(sd.openDataFile(start));
+    String path = sd.getDataFilePath();
+
+    uint32_t time = start;
+    uint32_t size = 0;
+    while (size < MAX_FILESIZE)
+    {
+        sd.appendData(time % 4000, time, 3.7f, 85.0f);
+        size += lineLength(time % 4000, time);
+        time++;
+    }
+    sd.closeDataFile();
+    CHECK_EQUAL(size, fileSize(path));
+
+    sd.appendData(time % 4000, time, 3.7f, 85.0f);
+    CHECK(sd.getDataFilePath() != path);
+    CHECK_EQUAL(size, fileSize(path));
+    checkSamples(path, start, time - start);
+
+    sd.sleep();
+    checkSamples(sd.getDataFilePath(), time, 1);
+    sdBus.unlock();
+}
+
+/**
+ * @brief Event log records and syncs are counted like data writes
+ *
+ */
+static void testEventLogStats(void)
+{
+    SD.format();
+    sdBus.resetStats();
+
+    sdBus.lock();
+    EventLog log;
+    CHECK(log.open());
+    uint8_t appending = 0;
+    for (uint8_t i = 0; i < LOG_FILE_COUNT; i++)
+    {
+        appending += sdBus.isAppending((String("/Log/log") + i + ".bin").c_str());
+    }
+    CHECK_EQUAL(1, appending);
+    CHECK(log.append(EVENT_BOOT, SOURCE_SD, 1));
+    CHECK(log.append(EVENT_FIX, SOURCE_CLOCK, 1, 2, 3));
+    CHECK(log.append(EVENT_ERROR, SOURCE_RADAR, ERROR_RADAR_MEASURE));
+    log.sync();
+
+    // The EVENT_LOG_START record of the new file and the three above
+    const SDStats& stats = sdBus.getStats();
+    CHECK_EQUAL(1, stats.opens);
+    CHECK_EQUAL(4, stats.writes);
+    CHECK_EQUAL(4 * EVENT_RECORD_SIZE, stats.bytes);
+    CHECK_EQUAL(4, stats.sectors);
+    CHECK_EQUAL(1, stats.syncs);
+    log.close();
+    for (uint8_t i = 0; i < LOG_FILE_COUNT; i++)
+    {
+        CHECK(!sdBus.isAppending((String("/Log/log") + i + ".bin").c_str()));
+    }
+    sdBus.unlock();
+}
+
+int main()
+{
+    testDataStats();
+    testReopenAtLimit();
+    testEventLogStats();
+    return hostTestResult();
+}
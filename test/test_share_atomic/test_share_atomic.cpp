@@ -0,0 +1,83 @@
+/**
+ * @file test_share_atomic.cpp
+ * @brief Which shares keep their data in an atomic word, and what that saves
+ * @details Word-sized shares read back what was put without a queue, start
+ *          out as zero and fill in the variable given to >>. The benchmark
+ *          times 7 gets to each put on a uint32_t share, once through the
+ *          queue version and once through the atomic one.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include <chrono>
+#include "hostTest.h"
+#include "waterSenseLibs/shares/taskshare.h"
+
+#define BENCH_OPS 20000000L ///< Gets and puts timed on each share
+
+// Word-sized and trivially copyable, nothing else
+static_assert(ShareIsAtomic<uint32_t>::value, "uint32_t is kept in an atomic");
+static_assert(ShareIsAtomic<bool>::value, "bool is kept in an atomic");
+static_assert(ShareIsAtomic<float>::value, "float is kept in an atomic");
+static_assert(!ShareIsAtomic<uint64_t>::value, "uint64_t needs a lock on the ESP32");
+static_assert(!ShareIsAtomic<String>::value, "String is not trivially copyable");
+
+/// ns per operation, one put for every 7 gets, the sum of what was read goes to sink
+template <class SharedWord>
+static double bench(SharedWord& share, uint32_t& sink)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint32_t sum = 0;
+    for (long i = 0; i < BENCH_OPS; i++)
+    {
+        if ((i & 7) == 0) share.put((uint32_t) i);
+        else sum += share.get();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    sink ^= sum;
+    return seconds * 1e9 / BENCH_OPS;
+}
+
+int main()
+{
+    // Zero before the first put, instead of blocking
+    Share<uint32_t> counter("counter");
+    CHECK_EQUAL(0, counter.get());
+    counter.put(0xDEADBEEF);
+    CHECK_EQUAL(0xDEADBEEF, counter.get());
+
+    Share<float> level("level");
+    level << -2.5f;
+    float read = 0;
+    level >> read;
+    CHECK(read == -2.5f);
+
+    Share<bool> flag("flag");
+    flag.put(true);
+    bool set = false;
+    flag >> set;
+    CHECK(set);
+
+    // >> fills in its parameter through the queue as well
+    Share<uint64_t> wide("wide");
+    wide.put(0x123456789ABCULL);
+    uint64_t readWide = 0;
+    wide >> readWide;
+    CHECK_EQUAL(0x123456789ABCULL, readWide);
+
+    Share<uint32_t, false> queued("queued");
+    Share<uint32_t> atomic("atomic");
+    queued.put(1);
+    atomic.put(1);
+    uint32_t sink = 0;
+    double queuedNs = bench(queued, sink);
+    double atomicNs = bench(atomic, sink);
+    printf("uint32_t share, 7 gets to 1 put: queue %.1f ns/op, atomic %.1f ns/op (%u)\n", queuedNs, atomicNs, sink & 1);
+    CHECK(atomicNs < queuedNs);
+
+    return hostTestResult();
+}
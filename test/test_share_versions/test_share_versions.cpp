@@ -0,0 +1,176 @@
+/**
+ * @file test_share_versions.cpp
+ * @brief Versions, dropped counts and waits on every kind of share, with threads
+ * @details A writer thread puts numbered data into an atomic Share, a queue
+ *          Share and a SnapshotShare while a reader thread polls with
+ *          get_if_newer() or blocks in wait_for_change(). Every version put
+ *          must be read or counted as dropped, and the data read must be the
+ *          data of its version. Two writers at once must leave the newest
+ *          version in the share.
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include <chrono>
+#include <thread>
+#include "hostTest.h"
+#include "waterSenseLibs/shares/taskshare.h"
+#include "waterSenseLibs/shares/snapshotshare.h"
+
+#define WAIT_PUTS 5000 ///< Puts made while the reader blocks in wait_for_change()
+#define WAIT_SPACING_US 200 ///< Time between those puts
+
+/// Bigger than a word, so a torn copy would show
+struct Triple
+{
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+};
+
+/// The data put as version i
+static int32_t makeWord(uint32_t i) { return (int32_t) i; }
+static uint64_t makeWide(uint32_t i) { return i; }
+static Triple makeTriple(uint32_t i) { Triple t = {i, i * 3, i * 7}; return t; }
+
+/// Whether data read is the data of the version it was read as
+static bool matches(int32_t data, uint32_t version) { return (uint32_t) data == version; }
+static bool matches(uint64_t data, uint32_t version) { return data == version; }
+static bool matches(const Triple& data, uint32_t version)
+{
+    return data.a == version && data.b == version * 3 && data.c == version * 7;
+}
+
+/**
+ * @brief One writer puts versions 1 to puts, one reader reads as many as it can
+ *
+ * @param label What is printed with the counts
+ * @param share A share nothing has been put into yet
+ * @param make Makes the data for a version
+ * @param puts How many versions to put
+ * @param waiting Whether the reader waits for changes instead of polling
+ */
+template <class SharedData, class DataType>
+static void readWhileWriting(const char* label, SharedData& share, DataType (*make)(uint32_t), uint32_t puts, bool waiting)
+{
+    uint32_t read = 0;
+    uint32_t mismatched = 0;
+    uint32_t timeouts = 0;
+    std::atomic<bool> done(false);
+
+    std::thread reader([&] {
+        uint32_t seen = 0;
+        DataType data;
+        while (true)
+        {
+            bool fresh = waiting ? share.wait_for_change(data, seen, 50) : share.get_if_newer(data, seen);
+            if (fresh)
+            {
+                read++;
+                if (!matches(data, seen)) mismatched++;
+            }
+            else if (waiting)
+            {
+                timeouts++;
+            }
+            if (done.load() && seen == share.version()) break;
+            if (!waiting) std::this_thread::yield();
+        }
+    });
+
+    for (uint32_t i = 1; i <= puts; i++)
+    {
+        share.put(make(i));
+        if (waiting) std::this_thread::sleep_for(std::chrono::microseconds(WAIT_SPACING_US));
+    }
+    done.store(true);
+    reader.join();
+
+    printf("%-28s puts %u, read %u, dropped %u, mismatched %u, timeouts %u\n", label, puts, read, share.dropped(), mismatched, timeouts);
+    CHECK_EQUAL(puts, share.version());
+    CHECK_EQUAL(puts, read + share.dropped());
+    CHECK_EQUAL(0, mismatched);
+    if (waiting)
+    {
+        // Puts are far enough apart that a waiting reader misses almost none
+        CHECK(share.dropped() <= puts / 100);
+    }
+}
+
+/**
+ * @brief Two writers put at once, the share must end up on the last version given out
+ *
+ * @param label What is printed with the counts
+ * @param share A share nothing has been put into yet
+ * @param make Makes the data for a version
+ * @param puts How many versions each writer puts
+ */
+template <class SharedData, class DataType>
+static void twoWriters(const char* label, SharedData& share, DataType (*make)(uint32_t), uint32_t puts)
+{
+    uint32_t backwards = 0;
+    std::atomic<bool> done(false);
+
+    // The version read never goes down
+    std::thread reader([&] {
+        uint32_t previous = 0;
+        while (!done.load())
+        {
+            uint32_t version = share.version();
+            if (version < previous) backwards++;
+            previous = version;
+        }
+    });
+
+    std::thread first([&] { for (uint32_t i = 1; i <= puts; i++) share.put(make(i)); });
+    std::thread second([&] { for (uint32_t i = 1; i <= puts; i++) share.put(make(i)); });
+    first.join();
+    second.join();
+    done.store(true);
+    reader.join();
+
+    printf("%-28s puts %u, last version %u, went backwards %u times\n", label, 2 * puts, share.version(), backwards);
+    CHECK_EQUAL(2 * puts, share.version());
+    CHECK_EQUAL(0, backwards);
+}
+
+int main()
+{
+    Share<int32_t> polledWord("polledWord");
+    readWhileWriting("atomic, polled", polledWord, makeWord, 500000, false);
+    Share<int32_t> waitedWord("waitedWord");
+    readWhileWriting("atomic, waiting", waitedWord, makeWord, WAIT_PUTS, true);
+
+    Share<uint64_t> polledWide("polledWide");
+    readWhileWriting("queue, polled", polledWide, makeWide, 200000, false);
+    Share<uint64_t> waitedWide("waitedWide");
+    readWhileWriting("queue, waiting", waitedWide, makeWide, WAIT_PUTS, true);
+
+    SnapshotShare<Triple> polledTriple("polledTriple");
+    readWhileWriting("snapshot, polled", polledTriple, makeTriple, 500000, false);
+    SnapshotShare<Triple> waitedTriple("waitedTriple");
+    readWhileWriting("snapshot, waiting", waitedTriple, makeTriple, WAIT_PUTS, true);
+
+    Share<int32_t> sharedWord("sharedWord");
+    twoWriters("atomic, two writers", sharedWord, makeWord, 200000);
+    Share<uint64_t> sharedWide("sharedWide");
+    twoWriters("queue, two writers", sharedWide, makeWide, 200000);
+    SnapshotShare<Triple> sharedTriple("sharedTriple");
+    twoWriters("snapshot, two writers", sharedTriple, makeTriple, 200000);
+
+    // Nothing put, the wait times out and leaves the data alone
+    Share<int32_t> idle("idle");
+    int32_t data = 99;
+    uint32_t seen = 0;
+    TickType_t start = xTaskGetTickCount();
+    CHECK(!idle.wait_for_change(data, seen, 100));
+    CHECK(xTaskGetTickCount() - start >= 100);
+    CHECK_EQUAL(99, data);
+    CHECK_EQUAL(0, idle.version());
+
+    return hostTestResult();
+}
@@ -0,0 +1,61 @@
+/**
+ * @file test_time_format.cpp
+ * @brief formatTimestamp() against the C library, and FixedString truncation
+ * @details Every 3599 s from 0 to 2^32 - 1, so each hour, minute and second
+ *          and every day of the years a uint32_t reaches, is written both
+ *          ways and compared
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <Arduino.h>
+#include <time.h>
+#include "hostTest.h"
+#include "waterSenseLibs/timeFormat/timeFormat.h"
+
+#define TIME_STEP 3599 ///< Seconds between the times checked, prime to 60 and 3600
+
+int main()
+{
+    uint32_t checked = 0;
+    uint32_t mismatched = 0;
+    for (uint64_t t = 0; t <= 0xFFFFFFFFULL; t += TIME_STEP)
+    {
+        char expected[32];
+        time_t time = (time_t) t;
+        struct tm fields;
+        gmtime_r(&time, &fields);
+        strftime(expected, sizeof(expected), "%Y-%m-%d %H:%M:%S", &fields);
+
+        char written[TIMESTAMP_SIZE];
+        size_t length = formatTimestamp((uint32_t) t, written);
+        checked++;
+        if (length != TIMESTAMP_SIZE - 1 || strcmp(expected, written) != 0)
+        {
+            if (mismatched++ < 5) fprintf(stderr, "%llu: %s, expected %s\n", (unsigned long long) t, written, expected);
+        }
+    }
+    printf("formatTimestamp: %u times checked against gmtime_r(), %u mismatched\n", checked, mismatched);
+    CHECK_EQUAL(0, mismatched);
+    CHECK(checked > 1190000);
+
+    // The Timestamp overload, and the ends of the range
+    Timestamp stamp;
+    formatTimestamp(1792195200UL, stamp);
+    CHECK(strcmp("2026-10-17 00:00:00", stamp.c_str()) == 0);
+    CHECK_EQUAL(TIMESTAMP_SIZE - 1, stamp.length());
+    formatTimestamp(0xFFFFFFFFUL, stamp);
+    CHECK(strcmp("2106-02-07 06:28:15", stamp.c_str()) == 0);
+
+    // Text that does not fit is cut short, never overrun
+    FixedString<8> small;
+    CHECK(!small.format("%d-%s", 12345, "abcdef"));
+    CHECK(strcmp("12345-a", small.c_str()) == 0);
+    CHECK(small.assign("short"));
+    CHECK(strcmp("short", small.c_str()) == 0);
+
+    return hostTestResult();
+}
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""Convert WaterSense binary sample files (/Data/*.bin) to CSV.
+
+The layout is described in src/waterSenseLibs/sdData/sdRecord.h: a file is a
+sequence of 16 byte little endian units, a header first, then sample records
+and block trailers holding the CRC32 of the units since the previous trailer.
+
+Usage:
+    python3 tools/wsbin2csv.py 6530a1f0.bin [more.bin ...] > samples.csv
+
+Samples from blocks whose CRC does not match, or from a tail that was never
+sealed by a trailer (power lost before the file was closed), are still written
+but reported on stderr.
+"""
+
+import struct
+import sys
+import zlib
+
+BIN_MAGIC = 0x4C425357
+BIN_VERSION = 1
+BIN_UNIT_SIZE = 16
+BIN_TRAILER_MARKER = 0xFFFFFFFF
+
+HEADER = struct.Struct("<IHHIHH")
+RECORD = struct.Struct("<Iiff")
+TRAILER = struct.Struct("<IHHII")
+
+CSV_HEADER = "UNIX Time (GMT), Distance (mm), Battery Voltage (V), Battery (%)"
+
+
+def decode(path, out):
+    """Write every sample in one binary file to out, return the number of bad blocks."""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if len(data) < BIN_UNIT_SIZE:
+        raise ValueError(f"{path}: too short for a header")
+    magic, version, unit_size, create_time, _, _ = HEADER.unpack_from(data, 0)
+    if magic != BIN_MAGIC:
+        raise ValueError(f"{path}: not a WaterSense binary file")
+    if version != BIN_VERSION or unit_size != BIN_UNIT_SIZE:
+        raise ValueError(f"{path}: unsupported version {version} (unit size {unit_size})")
+
+    bad_blocks = 0
+    block = []  # samples waiting for their trailer
+    crc = zlib.crc32(data[:BIN_UNIT_SIZE])
+    units = 1
+
+    for offset in range(BIN_UNIT_SIZE, len(data) - BIN_UNIT_SIZE + 1, BIN_UNIT_SIZE):
+        unit = data[offset:offset + BIN_UNIT_SIZE]
+        marker = struct.unpack_from("<I", unit)[0]
+        if marker == BIN_TRAILER_MARKER:
+            _, count, _, expected, sequence = TRAILER.unpack(unit)
+            if count != units or expected != crc:
+                bad_blocks += 1
+                print(f"{path}: block {sequence} at offset {offset} failed its CRC", file=sys.stderr)
+            for line in block:
+                out.write(line)
+            block = []
+            crc = 0
+            units = 0
+            continue
+
+        time, distance, battery, percent = RECORD.unpack(unit)
+        block.append(f"{time}, {distance}, {battery:.9g}, {percent:.9g}\n")
+        crc = zlib.crc32(unit, crc)
+        units += 1
+
+    if block:
+        print(f"{path}: last {len(block)} sample(s) were never sealed by a trailer", file=sys.stderr)
+        for line in block:
+            out.write(line)
+
+    return bad_blocks
+
+
+def main(paths):
+    if not paths:
+        print(__doc__, file=sys.stderr)
+        return 2
+
+    sys.stdout.write(CSV_HEADER + "\n")
+    bad_blocks = 0
+    for path in paths:
+        bad_blocks += decode(path, sys.stdout)
+    return 1 if bad_blocks else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""Convert the samples of a WaterSense BLE record query (SINCE or QUERY) to CSV.
+
+Save the notifications of the transfer back to back in one file, then:
+
+    python3 tools/wsdelta2csv.py stream.bin > samples.csv          # after "COMPRESS DELTA"
+    python3 tools/wsdelta2csv.py --raw stream.bin > samples.csv    # after "COMPRESS NONE"
+
+The DELTA encoding is described in src/waterSenseLibs/sampleCodec/sampleCodec.h:
+every sample is four LEB128 varints, the zigzag encoded differences of time
+and distance from the previous sample and the XOR of the battery floats with
+the previous ones. Without compression the stream is packed 16 byte
+SampleRecords (src/waterSenseLibs/sdData/sdRecord.h).
+
+To see how well recorded data compresses, and check that it decodes back to
+the same samples, give data files from the card:
+
+    python3 tools/wsdelta2csv.py --ratio Data/*.txt Data/*.bin
+"""
+
+import struct
+import sys
+
+BIN_UNIT_SIZE = 16
+BIN_TRAILER_MARKER = 0xFFFFFFFF
+RECORD = struct.Struct("<Iiff")
+BITS = struct.Struct("<I")
+FLOAT = struct.Struct("<f")
+
+CSV_HEADER = "UNIX Time (GMT), Distance (mm), Battery Voltage (V), Battery (%)"
+
+
+def float_bits(value):
+    return BITS.unpack(FLOAT.pack(value))[0]
+
+
+def bits_float(bits):
+    return FLOAT.unpack(BITS.pack(bits))[0]
+
+
+def zigzag(value):
+    return ((value << 1) ^ (value >> 31)) & 0xFFFFFFFF
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def put_varint(out, value):
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+
+
+def get_varint(data, offset):
+    value = 0
+    shift = 0
+    while True:
+        if offset >= len(data):
+            raise ValueError("stream ends inside a sample")
+        byte = data[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, offset
+        shift += 7
+
+
+def signed(value):
+    value &= 0xFFFFFFFF
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def encode(samples):
+    """Encode (time, distance, battery, percent) samples the way the device does."""
+    out = bytearray()
+    previous = (0, 0, 0, 0)
+    for time, distance, battery, percent in samples:
+        current = (time, distance, float_bits(battery), float_bits(percent))
+        put_varint(out, zigzag(signed(current[0] - previous[0])))
+        put_varint(out, zigzag(signed(current[1] - previous[1])))
+        put_varint(out, current[2] ^ previous[2])
+        put_varint(out, current[3] ^ previous[3])
+        previous = current
+    return bytes(out)
+
+
+def decode_delta(data):
+    """Return the samples of a DELTA stream."""
+    samples = []
+    time = distance = battery = percent = 0
+    offset = 0
+    while offset < len(data):
+        value, offset = get_varint(data, offset)
+        time = (time + unzigzag(value)) & 0xFFFFFFFF
+        value, offset = get_varint(data, offset)
+        distance = signed(distance + unzigzag(value))
+        value, offset = get_varint(data, offset)
+        battery ^= value
+        value, offset = get_varint(data, offset)
+        percent ^= value
+        samples.append((time, distance, bits_float(battery), bits_float(percent)))
+    return samples
+
+
+def decode_raw(data):
+    """Return the samples of an uncompressed stream."""
+    usable = len(data) - len(data) % RECORD.size
+    if usable < len(data):
+        print(f"ignoring {len(data) - usable} trailing byte(s)", file=sys.stderr)
+    return [RECORD.unpack_from(data, offset) for offset in range(0, usable, RECORD.size)]
+
+
+def read_data_file(path):
+    """Return the samples of a data file from the card, CSV or binary."""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if path.endswith(".bin"):
+        samples = []
+        for offset in range(BIN_UNIT_SIZE, len(data) - BIN_UNIT_SIZE + 1, BIN_UNIT_SIZE):
+            if BITS.unpack_from(data, offset)[0] != BIN_TRAILER_MARKER:
+                samples.append(RECORD.unpack_from(data, offset))
+        return samples
+
+    samples = []
+    for line in data.decode("ascii", "replace").splitlines():
+        fields = line.split(",")
+        try:
+            time, distance, battery, percent = int(fields[0]), int(fields[1]), float(fields[2]), float(fields[3])
+        except (ValueError, IndexError):
+            continue  # header or a line cut short
+        # The device parses the text into floats, round the same way
+        samples.append((time, distance, bits_float(float_bits(battery)), bits_float(float_bits(percent))))
+    return samples
+
+
+def ratio(paths):
+    card = samples = encoded = 0
+    for path in paths:
+        with open(path, "rb") as f:
+            size = len(f.read())
+        file_samples = read_data_file(path)
+        stream = encode(file_samples)
+        if decode_delta(stream) != file_samples:
+            print(f"{path}: samples did not decode back unchanged", file=sys.stderr)
+            return 1
+        card += size
+        samples += len(file_samples)
+        encoded += len(stream)
+        print(f"{path}: {len(file_samples)} samples, {size} bytes on the card, "
+              f"{len(file_samples) * RECORD.size} raw, {len(stream)} delta")
+
+    if encoded:
+        print(f"total: {samples} samples, {encoded / samples:.2f} bytes per sample, "
+              f"{samples * RECORD.size / encoded:.2f}x smaller than raw records, "
+              f"{card / encoded:.2f}x smaller than the files")
+    return 0
+
+
+def main(args):
+    if not args:
+        print(__doc__, file=sys.stderr)
+        return 2
+
+    if args[0] == "--ratio":
+        return ratio(args[1:])
+
+    raw = args[0] == "--raw"
+    paths = args[1:] if raw else args
+    sys.stdout.write(CSV_HEADER + "\n")
+    for path in paths:
+        with open(path, "rb") as f:
+            data = f.read()
+        for time, distance, battery, percent in (decode_raw(data) if raw else decode_delta(data)):
+            sys.stdout.write(f"{time}, {distance}, {battery:.9g}, {percent:.9g}\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""Convert the WaterSense event log (/Log/log*.bin) to CSV.
+
+The layout is described in src/waterSenseLibs/eventLog/eventLog.h: every file
+is a sequence of 24 byte little endian records, the first one an
+EVENT_LOG_START record holding the sequence number of the file. Files are
+written oldest first by sequence number, so their order on the card does not
+matter.
+
+Usage:
+    python3 tools/wslog2csv.py Log/log*.bin > events.csv
+"""
+
+import struct
+import sys
+
+RECORD = struct.Struct("<IIHHiii")
+
+EVENT_LOG_START = 0
+EVENT_TYPES = [
+    "LOG_START",
+    "BOOT",
+    "WAKE",
+    "SLEEP",
+    "FIX",
+    "WATCHDOG",
+    "ERROR",
+    "BLE_CONNECT",
+    "BLE_DISCONNECT",
+]
+SOURCES = ["SD", "CLOCK", "RADAR", "SLEEP", "BLUETOOTH", "WATCH"]
+
+CSV_HEADER = "Sequence, UNIX Time (GMT), Wake Count, Event, Source, Value 0, Value 1, Value 2"
+
+
+def name(names, index):
+    return names[index] if index < len(names) else str(index)
+
+
+def read_records(path):
+    """Return the sequence number of one log file and its records."""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    usable = len(data) - len(data) % RECORD.size
+    if usable < len(data):
+        print(f"{path}: ignoring {len(data) - usable} trailing byte(s)", file=sys.stderr)
+
+    records = [RECORD.unpack_from(data, offset) for offset in range(0, usable, RECORD.size)]
+    if not records or records[0][2] != EVENT_LOG_START:
+        raise ValueError(f"{path}: not a WaterSense event log")
+    return records[0][4], records
+
+
+def main(paths):
+    if not paths:
+        print(__doc__, file=sys.stderr)
+        return 2
+
+    logs = sorted(read_records(path) for path in paths)
+
+    sys.stdout.write(CSV_HEADER + "\n")
+    for sequence, records in logs:
+        for time, wake, event, source, value0, value1, value2 in records:
+            sys.stdout.write(f"{sequence}, {time}, {wake}, {name(EVENT_TYPES, event)}, "
+                             f"{name(SOURCES, source)}, {value0}, {value1}, {value2}\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))